@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+"""
+Benchmark del tempo di compilazione e della dimensione del binario.
+
+Genera un codice sorgente con N segnali (default 200) distribuiti su piu'
+translation unit, ognuno con connect, emit e disconnect, e lo compila
+contro il SObject dell'albero corrente. Con --ref si compila lo stesso
+codice anche contro una revisione git (se la revisione e' header-only le
+translation unit vengono compilate come un'unica unity build, perche' il
+vecchio header non e' includibile in piu' translation unit). Le revisioni
+precedenti al supporto dei segnali con piu' parametri richiedono --max-args 1.
+
+Esempio:
+    python3 benchmarks/compile_bench.py --signals 200 --ref <commit> --max-args 1
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+ARG_TYPES = ["int", "double", "long", "float", "unsigned", "short", "char", "bool"]
+
+
+def generate(directory, signals, per_unit, max_args):
+    """Scrive le translation unit generate e restituisce i loro nomi."""
+    units = []
+    for unit in range((signals + per_unit - 1) // per_unit):
+        first = unit * per_unit
+        count = min(per_unit, signals - first)
+        lines = ['#include "sobject.h"', ""]
+        lines.append("namespace unit%d {" % unit)
+        lines.append("struct Emitter : SObject {")
+        for i in range(count):
+            arg = ARG_TYPES[(first + i) % len(ARG_TYPES)]
+            # Firme diverse per ogni segnale: numero e tipo dei parametri variano
+            params = ", ".join([arg] * (1 + (first + i) % max_args))
+            lines.append("    S_SIGNAL void signal%d(%s) {}" % (i, params))
+        for i in range(count):
+            arg = ARG_TYPES[(first + i) % len(ARG_TYPES)]
+            n = 1 + (first + i) % max_args
+            values = ", ".join("%s(%d)" % (arg, k) for k in range(n))
+            lines.append("    void fire%d() { emitSignal(&Emitter::signal%d, %s); }" % (i, i, values))
+        lines.append("};")
+        lines.append("struct Receiver : SObject {")
+        lines.append("    long total = 0;")
+        for i in range(count):
+            arg = ARG_TYPES[(first + i) % len(ARG_TYPES)]
+            n = 1 + (first + i) % max_args
+            params = ", ".join("%s a%d" % (arg, k) for k in range(n))
+            body = " + ".join("long(a%d)" % k for k in range(n))
+            lines.append("    S_SLOT void slot%d(%s) { total += %s; }" % (i, params, body))
+        lines.append("};")
+        lines.append("}")
+        lines.append("")
+        lines.append("long run_unit%d()" % unit)
+        lines.append("{")
+        lines.append("    unit%d::Emitter emitter;" % unit)
+        lines.append("    unit%d::Receiver receiver;" % unit)
+        for i in range(count):
+            lines.append("    connect(&emitter, &unit%d::Emitter::signal%d, &receiver, &unit%d::Receiver::slot%d);" % (unit, i, unit, i))
+        for i in range(count):
+            lines.append("    emitter.fire%d();" % i)
+        for i in range(count):
+            lines.append("    disconnect(&emitter, &unit%d::Emitter::signal%d, &receiver);" % (unit, i))
+        lines.append("    return receiver.total;")
+        lines.append("}")
+        name = "unit%d.cpp" % unit
+        with open(os.path.join(directory, name), "w") as f:
+            f.write("\n".join(lines) + "\n")
+        units.append(name)
+
+    lines = ['#include <cstdio>', ""]
+    for unit in range(len(units)):
+        lines.append("long run_unit%d();" % unit)
+    lines.append("")
+    lines.append("int main()")
+    lines.append("{")
+    lines.append("    long total = 0;")
+    for unit in range(len(units)):
+        lines.append("    total += run_unit%d();" % unit)
+    lines.append('    std::printf("%ld\\n", total);')
+    lines.append("    return 0;")
+    lines.append("}")
+    with open(os.path.join(directory, "main.cpp"), "w") as f:
+        f.write("\n".join(lines) + "\n")
+
+    return units
+
+
+def compile_source(compiler, flags, include, source, output):
+    """Compila una translation unit e restituisce il tempo impiegato."""
+    command = [compiler] + flags + ["-I", include, "-c", source, "-o", output]
+    start = time.perf_counter()
+    subprocess.check_call(command)
+    return time.perf_counter() - start
+
+
+def build(name, compiler, flags, sobject_dir, code_dir, units, work):
+    """Compila il codice generato contro la versione di SObject in sobject_dir."""
+    os.makedirs(work)
+    objects = []
+    seconds = 0.0
+
+    library = os.path.join(sobject_dir, "sobject.cpp")
+    if os.path.exists(library):
+        # Libreria compilata: ogni translation unit separata piu' sobject.cpp
+        sources = [os.path.join(code_dir, unit) for unit in units] + [library]
+    else:
+        # Header-only: unity build con tutte le translation unit
+        unity = os.path.join(work, "unity.cpp")
+        with open(unity, "w") as f:
+            for unit in units:
+                f.write('#include "%s"\n' % os.path.join(code_dir, unit))
+        sources = [unity]
+    sources.append(os.path.join(code_dir, "main.cpp"))
+
+    for index, source in enumerate(sources):
+        output = os.path.join(work, "object%d.o" % index)
+        seconds += compile_source(compiler, flags, sobject_dir, source, output)
+        objects.append(output)
+
+    binary = os.path.join(work, "bench")
+    start = time.perf_counter()
+    subprocess.check_call([compiler] + flags + objects + ["-o", binary])
+    seconds += time.perf_counter() - start
+
+    stripped = binary + ".stripped"
+    shutil.copy(binary, stripped)
+    subprocess.check_call(["strip", stripped])
+
+    result = subprocess.check_output([binary]).decode().strip()
+
+    return {
+        "name": name,
+        "seconds": seconds,
+        "objects": sum(os.path.getsize(o) for o in objects),
+        "binary": os.path.getsize(binary),
+        "stripped": os.path.getsize(stripped),
+        "result": result,
+    }
+
+
+def checkout(ref, directory):
+    """Estrae sobject.h (e sobject.cpp se presente) dalla revisione git."""
+    os.makedirs(directory)
+    subprocess.check_call(["git", "-C", ROOT, "rev-parse", "--verify", "--quiet", ref + "^{commit}"], stdout=subprocess.DEVNULL)
+    for name in ("sobject.h", "sobject.cpp"):
+        try:
+            content = subprocess.check_output(["git", "-C", ROOT, "show", "%s:%s" % (ref, name)], stderr=subprocess.DEVNULL)
+        except subprocess.CalledProcessError:
+            continue
+        with open(os.path.join(directory, name), "wb") as f:
+            f.write(content)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--signals", type=int, default=200, help="numero di segnali generati")
+    parser.add_argument("--per-unit", type=int, default=20, help="segnali per translation unit")
+    parser.add_argument("--max-args", type=int, default=3, help="numero massimo di parametri per segnale")
+    parser.add_argument("--compiler", default=os.environ.get("CXX", "c++"))
+    parser.add_argument("--flags", default="-std=c++11 -O2", help="flag di compilazione")
+    parser.add_argument("--ref", action="append", default=[], help="revisione git da confrontare (ripetibile)")
+    args = parser.parse_args()
+
+    flags = args.flags.split()
+    work = tempfile.mkdtemp(prefix="sobject_compile_bench_")
+    try:
+        code_dir = os.path.join(work, "code")
+        os.makedirs(code_dir)
+        units = generate(code_dir, args.signals, args.per_unit, args.max_args)
+
+        results = [build("working tree", args.compiler, flags, ROOT, code_dir, units, os.path.join(work, "tree"))]
+        for index, ref in enumerate(args.ref):
+            ref_dir = os.path.join(work, "ref%d" % index)
+            checkout(ref, ref_dir)
+            results.append(build(ref, args.compiler, flags, ref_dir, code_dir, units, os.path.join(work, "build%d" % index)))
+
+        print("%d segnali, %d translation unit, %s %s" % (args.signals, len(units), args.compiler, args.flags))
+        print("%-16s %12s %14s %14s %14s" % ("versione", "compile [s]", "oggetti [B]", "binario [B]", "strip [B]"))
+        for r in results:
+            print("%-16s %12.2f %14d %14d %14d" % (r["name"], r["seconds"], r["objects"], r["binary"], r["stripped"]))
+
+        if len(set(r["result"] for r in results)) != 1:
+            print("ATTENZIONE: i binari producono risultati diversi", file=sys.stderr)
+            return 1
+    finally:
+        shutil.rmtree(work)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,147 @@
+/* ===========================================================================
+ *
+ *    Benchmark di contesa tra thread.
+ *
+ *    Ogni thread emette su un gruppo di emitter condivisi e ogni --write-every
+ *    emit effettua una connect e una disconnect. Oltre al throughput degli emit
+ *    riporta la latenza peggiore di una connect mentre gli altri thread
+ *    continuano a emettere. Lo stesso sorgente viene compilato tre volte:
+ *      - con SOBJECT_THREAD_SAFE usa i lock a stripe della libreria;
+ *      - con SOBJECT_SEQLOCK_EMIT gli emit leggono gli snapshot senza lock;
+ *      - senza, protegge ogni emit, connect e disconnect con un unico mutex
+ *        globale (l'alternativa più semplice ai lock per emitter).
+ *
+ *    Esempio:
+ *        sobject_contention_striped --threads 8 --emitters 64 --emits 1000000
+ *
+ * ===========================================================================
+ */
+
+#include "sobject.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(SOBJECT_SEQLOCK_EMIT)
+static const char* const lockName = "seqlock";
+#elif defined(SOBJECT_THREAD_SAFE)
+static const char* const lockName = "striped";
+#else
+static const char* const lockName = "global mutex";
+static std::mutex globalMutex;
+#endif
+
+class Receiver : public SObject
+{
+public:
+    S_SLOT void onValue(int value)
+    {
+        m_total.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    std::atomic<long> m_total{0};
+};
+
+class Emitter : public SObject
+{
+public:
+    S_SIGNAL void valueChanged(int) {}
+
+    void fire(int value)
+    {
+#ifndef SOBJECT_THREAD_SAFE
+        std::lock_guard<std::mutex> lock(globalMutex);
+#endif
+        emitSignal(&Emitter::valueChanged, value);
+    }
+};
+
+// Ritorna la durata della connect in nanosecondi, compresa l'attesa del lock
+static long rewire(Emitter* emitter, Receiver* receiver)
+{
+    const auto begin = std::chrono::steady_clock::now();
+#ifndef SOBJECT_THREAD_SAFE
+    std::lock_guard<std::mutex> lock(globalMutex);
+#endif
+    connect(emitter, &Emitter::valueChanged, receiver, &Receiver::onValue);
+    const auto end = std::chrono::steady_clock::now();
+
+    disconnect(emitter, &Emitter::valueChanged, receiver, &Receiver::onValue);
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+}
+
+static long argument(int argc, char** argv, const char* name, long fallback)
+{
+    for(int i = 1; i + 1 < argc; ++i)
+    {
+        if(std::strcmp(argv[i], name) == 0) return std::atol(argv[i + 1]);
+    }
+
+    return fallback;
+}
+
+int main(int argc, char** argv)
+{
+    const long maxThreads  = argument(argc, argv, "--threads", std::thread::hardware_concurrency());
+    const long emitters    = argument(argc, argv, "--emitters", 64);
+    const long receivers   = argument(argc, argv, "--receivers", 4);
+    const long emits       = argument(argc, argv, "--emits", 1000000);
+    const long writeEvery  = argument(argc, argv, "--write-every", 1000);
+
+    std::vector<Emitter> emitterList(emitters);
+    std::vector<Receiver> receiverList(receivers * emitters);
+
+    for(long e = 0; e < emitters; ++e)
+    {
+        for(long r = 0; r < receivers; ++r)
+        {
+            connect(&emitterList[e], &Emitter::valueChanged, &receiverList[e * receivers + r], &Receiver::onValue);
+        }
+    }
+
+    std::printf("%s, %ld emitter, %ld receiver per emitter, 1 connect/disconnect ogni %ld emit\n",
+                lockName, emitters, receivers, writeEvery);
+    std::printf("%8s %14s %14s %16s\n", "thread", "emit/s", "ns/emit", "max us/connect");
+
+    for(long threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        std::atomic<bool> start{false};
+        std::vector<std::thread> workers;
+        std::vector<long> maxConnect(threads, 0);
+
+        for(long t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]
+            {
+                Receiver extra;
+                while(not start.load(std::memory_order_acquire)) {}
+
+                for(long i = 0; i < emits; ++i)
+                {
+                    Emitter& emitter = emitterList[(t * 7919 + i) % emitters];
+                    emitter.fire(1);
+
+                    if(writeEvery > 0 and i % writeEvery == 0) maxConnect[t] = std::max(maxConnect[t], rewire(&emitter, &extra));
+                }
+            });
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        start.store(true, std::memory_order_release);
+        for(std::thread& worker : workers) worker.join();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        const double total = double(threads) * double(emits);
+        const long worst = *std::max_element(maxConnect.begin(), maxConnect.end());
+        std::printf("%8ld %14.0f %14.1f %16.1f\n", threads, total / seconds, seconds * 1e9 / total * double(threads), worst / 1e3);
+    }
+
+    return 0;
+}
@@ -0,0 +1,3494 @@
+#include "sobject.h"
+
+#include <algorithm>
+#include <functional>
+
+#ifdef SOBJECT_THREAD_SAFE
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
+#if defined(__x86_64__) and (defined(__GNUC__) or defined(__clang__))
+#include <immintrin.h>
+#endif
+
+#if defined(SOBJECT_THREAD_SAFE) and defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/* ===========================================================================
+ *
+ *    Implementazione delle parti non template di SObject.
+ *    Tutte le istanze dei template (una per firma di segnale) condividono
+ *    questo codice, compilato una sola volta nella libreria.
+ *
+ * ===========================================================================
+ */
+
+namespace _sobject
+{
+
+#ifdef SOBJECT_THREAD_SAFE
+
+// =======================================
+//
+//             StripeLock
+//
+// =======================================
+
+namespace
+{
+
+// Ogni stripe occupa una cache line, così i lock di oggetti diversi non si contendono la stessa linea.
+// writers conta gli scrittori in attesa: i nuovi lettori li lasciano passare
+struct alignas(64) Stripe
+{
+    std::atomic<unsigned> state{0};
+    std::atomic<unsigned> writers{0};
+};
+
+// Bit alto: scrittore attivo, bit bassi: numero di lettori
+const unsigned writerBit = 0x80000000u;
+
+// Tentativi su uno stripe occupato prima di rilasciare quelli già presi
+const unsigned writerSpins = 1024;
+
+Stripe stripes[_StripeCount];
+
+// Lock posseduti dal thread corrente: letture attive e profondità delle scritture per stripe
+thread_local unsigned sharedHolds[_StripeCount];
+thread_local unsigned exclusiveHolds[_StripeCount];
+
+// Lock presi dal thread corrente su tutti gli stripe (letture e scritture)
+thread_local unsigned heldLocks = 0;
+
+// Segnali scorsi dagli emit in corso del thread (dal più esterno) e quanti, dall'inizio,
+// sono segnati come in uso perché il thread ha rilasciato i propri lock
+thread_local std::vector<_SignalBase*> iterations;
+thread_local std::size_t publishedIterations = 0;
+
+// Emit del thread corrente sul segnale tra i primi count
+unsigned ownIterations(const _SignalBase* signal, std::size_t count)
+{
+    return static_cast<unsigned>(std::count(iterations.begin(), iterations.begin() + count, signal));
+}
+
+bool inMask(std::uint64_t mask, std::size_t index)
+{
+    return (mask >> index) & 1;
+}
+
+// Con yieldToWriters la lettura aspetta anche gli scrittori in attesa, che altrimenti con emit continui
+// non troverebbero mai lo stripe libero. Solo un thread senza lock può aspettarli: uno scrittore in attesa
+// può dipendere dai lock che possiede (es. emit annidato in una slot), e aspettarlo porterebbe a un deadlock
+void lockShared(std::size_t index, bool yieldToWriters)
+{
+    Stripe& stripe = stripes[index];
+
+    for(;;)
+    {
+        unsigned value = stripe.state.load(std::memory_order_relaxed);
+        if(not (value & writerBit) and not (yieldToWriters and stripe.writers.load(std::memory_order_relaxed) != 0) and
+           stripe.state.compare_exchange_weak(value, value + 1, std::memory_order_acquire))
+        {
+            ++heldLocks;
+            return;
+        }
+
+        std::this_thread::yield();
+    }
+}
+
+void unlockShared(std::size_t index)
+{
+    stripes[index].state.fetch_sub(1, std::memory_order_release);
+    --heldLocks;
+}
+
+bool tryLock(std::size_t index)
+{
+    std::atomic<unsigned>& state = stripes[index].state;
+
+    for(unsigned spin = 0; spin < writerSpins; ++spin)
+    {
+        unsigned value = 0;
+        if(state.load(std::memory_order_relaxed) == 0 and state.compare_exchange_weak(value, writerBit, std::memory_order_acquire))
+        {
+            ++heldLocks;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void unlock(std::size_t index)
+{
+    stripes[index].state.store(0, std::memory_order_release);
+    --heldLocks;
+}
+
+void unlockMask(std::uint64_t mask)
+{
+    for(std::size_t index = 0; index < _StripeCount; ++index)
+    {
+        if(inMask(mask, index)) unlock(index);
+    }
+}
+
+void setWaiting(std::uint64_t mask, bool waiting)
+{
+    for(std::size_t index = 0; index < _StripeCount; ++index)
+    {
+        if(not inMask(mask, index)) continue;
+
+        if(waiting) stripes[index].writers.fetch_add(1, std::memory_order_relaxed);
+        else stripes[index].writers.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// Acquisisco tutti gli stripe in ordine di indirizzo, se uno è occupato
+// rilascio quelli già presi e riprovo (nessuna attesa tenendo altri lock).
+// Per tutta l'attesa gli stripe sono segnati come richiesti da uno scrittore
+void lockMask(std::uint64_t mask)
+{
+    setWaiting(mask, true);
+
+    for(;;)
+    {
+        std::uint64_t acquired = 0;
+
+        for(std::size_t index = 0; index < _StripeCount; ++index)
+        {
+            if(not inMask(mask, index)) continue;
+            if(not tryLock(index)) break;
+            acquired |= std::uint64_t(1) << index;
+        }
+
+        if(acquired == mask) break;
+
+        unlockMask(acquired);
+        std::this_thread::yield();
+    }
+
+    setWaiting(mask, false);
+}
+
+} // namespace
+
+_StripeReadLock::_StripeReadLock(const void* object) : m_stripe(_stripeIndex(object))
+{
+    // Il thread possiede già lo stripe in esclusiva (es. emit annidato in una slot single shot)
+    if(exclusiveHolds[m_stripe] != 0)
+    {
+        m_stripe = _StripeCount;
+        return;
+    }
+
+    lockShared(m_stripe, heldLocks == 0);
+    ++sharedHolds[m_stripe];
+}
+
+_StripeReadLock::~_StripeReadLock()
+{
+    if(m_stripe == _StripeCount) return;
+
+    --sharedHolds[m_stripe];
+    unlockShared(m_stripe);
+}
+
+_StripeWriteLock::_StripeWriteLock(std::uint64_t mask) : m_mask(0)
+{
+    // Maschera vuota (es. emit senza slot single shot): nessun lock
+    if(mask == 0) return;
+
+    std::uint64_t owned = 0;
+
+    for(std::size_t index = 0; index < _StripeCount; ++index)
+    {
+        if(exclusiveHolds[index] != 0) owned |= std::uint64_t(1) << index;
+    }
+
+    // Gli stripe già posseduti in esclusiva vengono riutilizzati
+    m_mask = mask & ~owned;
+    if(m_mask == 0) return;
+
+    // Senza i lock del thread altri thread possono modificare i segnali che i suoi emit stanno
+    // scorrendo: li segno come in uso, così le slot rimosse vengono trattenute e i segnali non eliminati
+    m_published = publishedIterations;
+    for(std::size_t i = m_published; i < iterations.size(); ++i) iterations[i]->m_suspendedIterations.fetch_add(1, std::memory_order_relaxed);
+    publishedIterations = iterations.size();
+
+    // Rilascio tutti i lock del thread: le letture vengono riprese nel distruttore,
+    // le scritture esterne vengono riacquisite insieme ai nuovi stripe
+    for(std::size_t index = 0; index < _StripeCount; ++index)
+    {
+        m_suspended[index] = sharedHolds[index];
+        for(unsigned i = 0; i < sharedHolds[index]; ++i) unlockShared(index);
+        sharedHolds[index] = 0;
+    }
+
+    unlockMask(owned);
+    lockMask(m_mask | owned);
+
+    for(std::size_t index = 0; index < _StripeCount; ++index)
+    {
+        if(inMask(m_mask, index)) ++exclusiveHolds[index];
+    }
+}
+
+_StripeWriteLock::~_StripeWriteLock()
+{
+    if(m_mask == 0) return;
+
+    for(std::size_t index = 0; index < _StripeCount; ++index)
+    {
+        if(inMask(m_mask, index)) --exclusiveHolds[index];
+    }
+
+    unlockMask(m_mask);
+
+    // Le letture riprese appartengono a emit già iniziati: non lasciano passare gli scrittori in attesa
+    for(std::size_t index = 0; index < _StripeCount; ++index)
+    {
+        for(unsigned i = 0; i < m_suspended[index]; ++i) lockShared(index, false);
+        sharedHolds[index] = m_suspended[index];
+    }
+
+    // Con i lock di nuovo in mano nessun altro thread modifica i segnali
+    for(std::size_t i = m_published; i < publishedIterations; ++i) iterations[i]->m_suspendedIterations.fetch_sub(1, std::memory_order_relaxed);
+    publishedIterations = m_published;
+}
+
+#endif // SOBJECT_THREAD_SAFE
+
+
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+
+// =======================================
+//
+//                Epoch
+//
+// =======================================
+
+namespace
+{
+
+// Epoca pubblicata da ogni thread (0 se non è dentro un emit). Il padding tiene
+// le epoche di thread diversi su cache line diverse
+struct ThreadRecord
+{
+    std::atomic<std::uint64_t> epoch{0};
+    char padding[64];
+    std::atomic<bool> used{true};
+    ThreadRecord* next = nullptr;
+};
+
+struct Retired
+{
+    void* pointer;
+    void (*deleter)(void*);
+    std::uint64_t epoch;
+};
+
+// Oggetti ritirati oltre i quali si prova a eliminarli
+const std::size_t reclaimThreshold = 64;
+
+std::atomic<ThreadRecord*> threadRecords{nullptr};
+std::atomic<std::uint64_t> globalEpoch{1};
+
+_SpinLock retiredLock;
+
+// Alla chiusura del programma elimino gli oggetti ancora ritirati. Gli SObject statici distrutti
+// dopo la lista eliminano subito i propri oggetti (non ci sono più emit in corso)
+bool retiredClosed = false;
+
+struct RetiredList
+{
+    ~RetiredList()
+    {
+        for(const Retired& retired : entries) retired.deleter(retired.pointer);
+        entries.clear();
+        retiredClosed = true;
+    }
+
+    std::vector<Retired> entries;
+};
+
+RetiredList retiredList;
+
+// I record dei thread terminati vengono riutilizzati, la lista non viene mai accorciata
+ThreadRecord* acquireRecord()
+{
+    for(ThreadRecord* record = threadRecords.load(std::memory_order_acquire); record != nullptr; record = record->next)
+    {
+        bool used = false;
+        if(not record->used.load(std::memory_order_relaxed) and record->used.compare_exchange_strong(used, true)) return record;
+    }
+
+    ThreadRecord* record = new ThreadRecord;
+    record->next = threadRecords.load(std::memory_order_relaxed);
+    while(not threadRecords.compare_exchange_weak(record->next, record, std::memory_order_release)) {}
+
+    return record;
+}
+
+struct ThreadState
+{
+    ThreadState() : record(acquireRecord()) {}
+
+    ~ThreadState()
+    {
+        record->epoch.store(0, std::memory_order_release);
+        record->used.store(false, std::memory_order_release);
+    }
+
+    ThreadRecord* const record;
+    unsigned depth = 0;
+};
+
+thread_local ThreadState threadState;
+
+// Epoca più vecchia tra gli emit in corso. Parto dall'epoca globale: gli emit che iniziano
+// durante la scansione possono leggere gli oggetti ritirati da ora in poi, che quindi restano
+std::uint64_t oldestEpoch()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    std::uint64_t oldest = globalEpoch.load(std::memory_order_acquire);
+    for(ThreadRecord* record = threadRecords.load(std::memory_order_acquire); record != nullptr; record = record->next)
+    {
+        const std::uint64_t epoch = record->epoch.load(std::memory_order_acquire);
+        if(epoch != 0 and epoch < oldest) oldest = epoch;
+    }
+
+    return oldest;
+}
+
+// Elimino gli oggetti ritirati prima dell'emit in corso più vecchio.
+// I distruttori possono ritirare altri oggetti, quindi vengono chiamati fuori dallo spin lock
+void reclaim()
+{
+    const std::uint64_t oldest = oldestEpoch();
+    std::vector<Retired> freeable;
+
+    {
+        _SpinGuard guard(retiredLock);
+
+        std::vector<Retired>& entries = retiredList.entries;
+
+        auto keep = std::partition(entries.begin(), entries.end(), [oldest](const Retired& retired) { return retired.epoch >= oldest; });
+        freeable.assign(keep, entries.end());
+        entries.erase(keep, entries.end());
+    }
+
+    for(const Retired& retired : freeable)
+    {
+        retired.deleter(retired.pointer);
+    }
+}
+
+} // namespace
+
+_EpochGuard::_EpochGuard()
+{
+    ThreadState& state = threadState;
+    if(state.depth++ != 0) return;
+
+    // Store dell'epoca e fence: l'emit non esegue scritture atomiche RMW
+    state.record->epoch.store(globalEpoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+_EpochGuard::~_EpochGuard()
+{
+    ThreadState& state = threadState;
+    if(--state.depth == 0) state.record->epoch.store(0, std::memory_order_release);
+}
+
+void _retire(void* pointer, void (*deleter)(void*))
+{
+    if(retiredClosed)
+    {
+        deleter(pointer);
+        return;
+    }
+
+    // L'oggetto non è più pubblicato: gli emit che iniziano dopo questa epoca non possono leggerlo
+    const std::uint64_t epoch = globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+
+    std::size_t count = 0;
+    {
+        _SpinGuard guard(retiredLock);
+        retiredList.entries.push_back({ pointer, deleter, epoch });
+        count = retiredList.entries.size();
+    }
+
+    if(count >= reclaimThreshold) reclaim();
+}
+
+void _synchronize()
+{
+    const std::uint64_t epoch = globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for(ThreadRecord* record = threadRecords.load(std::memory_order_acquire); record != nullptr; record = record->next)
+    {
+        if(record == threadState.record) continue;
+
+        for(;;)
+        {
+            const std::uint64_t current = record->epoch.load(std::memory_order_acquire);
+            if(current == 0 or current > epoch) break;
+            std::this_thread::yield();
+        }
+    }
+
+    reclaim();
+}
+
+bool _inEpoch()
+{
+    return threadState.depth != 0;
+}
+
+#endif // SOBJECT_SEQLOCK_EMIT
+
+
+
+// =======================================
+//
+//               Future
+//
+// =======================================
+
+void _FutureCore::wait() const
+{
+#ifdef SOBJECT_THREAD_SAFE
+    while(not isReady()) std::this_thread::yield();
+#endif
+}
+
+void _FutureCore::resume()
+{
+    m_continuation();
+    m_continuation.reset();
+
+    if(m_ownsReference) release();
+}
+
+void _FutureCore::prepare(unsigned references)
+{
+#ifdef SOBJECT_THREAD_SAFE
+    m_stage.store(Pending, std::memory_order_relaxed);
+    m_references.store(references, std::memory_order_relaxed);
+#else
+    m_stage      = Pending;
+    m_references = references;
+#endif
+    m_cancelled     = false;
+    m_ownsReference = false;
+}
+
+void _FutureCore::complete(bool cancelled)
+{
+    m_cancelled = cancelled;
+
+    // Il valore è pubblicato dallo stesso exchange che legge la presenza della continuazione
+#ifdef SOBJECT_THREAD_SAFE
+    const unsigned previous = m_stage.exchange(Ready, std::memory_order_acq_rel);
+#else
+    const unsigned previous = m_stage;
+    m_stage                 = Ready;
+#endif
+
+    if(previous == Waiting) resume();
+}
+
+void _FutureCore::release()
+{
+#ifdef SOBJECT_THREAD_SAFE
+    if(m_references.fetch_sub(1, std::memory_order_acq_rel) == 1) recycle();
+#else
+    if(--m_references == 0) recycle();
+#endif
+}
+
+bool _FutureCore::park()
+{
+#ifdef SOBJECT_THREAD_SAFE
+    unsigned expected = Pending;
+    return m_stage.compare_exchange_strong(expected, Waiting, std::memory_order_acq_rel, std::memory_order_acquire);
+#else
+    if(m_stage != Pending) return false;
+    m_stage = Waiting;
+    return true;
+#endif
+}
+
+
+
+// =======================================
+//
+//              MethodKey
+//
+// =======================================
+
+std::size_t _MethodKey::hash() const
+{
+    std::size_t seed = std::hash<const void*>()(m_type);
+
+    // Il puntatore a metodo non è convertibile in intero, uso i suoi byte
+    for(std::size_t i = 0; i < sizeof(m_method); ++i)
+    {
+        seed = seed * 31 + m_method[i];
+    }
+
+    return seed;
+}
+
+
+
+// =======================================
+//
+//             RateLimiter
+//
+// =======================================
+
+double _ticksPerSecond()
+{
+#if defined(__x86_64__) or defined(__i386__)
+    // Confronto il TSC con steady_clock su un breve intervallo (una sola volta per processo)
+    static const double ticksPerSecond = []
+    {
+        const auto begin          = std::chrono::steady_clock::now();
+        const std::uint64_t first = _ticks();
+
+        while(std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(2)) {}
+
+        const std::uint64_t last = _ticks();
+        const double seconds     = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return double(last - first) / seconds;
+    }();
+
+    return ticksPerSecond;
+#else
+    return double(std::chrono::steady_clock::period::den) / double(std::chrono::steady_clock::period::num);
+#endif
+}
+
+namespace
+{
+// Intervalli e tolleranze oltre questo valore vengono saturati: la conversione da double resta definita
+// e l'istante di arrivo (ora + tolleranza + intervallo) non supera la capacità di std::uint64_t
+const double maxTicks = double(std::uint64_t(1) << 61);
+
+std::uint64_t saturatedTicks(double ticks)
+{
+    return static_cast<std::uint64_t>(std::min(std::max(ticks, 0.0), maxTicks));
+}
+}
+
+// Il limite è già stato validato dalla connect (isValid)
+_RateLimiter::_RateLimiter(const SRateLimit& limit)
+    : m_interval(saturatedTicks(_ticksPerSecond() / limit.perSecond)),
+      m_tolerance(saturatedTicks(double(m_interval) * (limit.burst - 1.0)))
+{
+}
+
+
+
+// =======================================
+//
+//              SlotCore
+//
+// =======================================
+
+_SlotCore::~_SlotCore()
+{
+    unlink();
+    delete m_limiter;
+}
+
+void _SlotCore::setRateLimit(const SRateLimit& limit)
+{
+    delete m_limiter;
+    m_limiter  = new _RateLimiter(limit);
+    m_filtered = true;
+}
+
+void _SlotCore::setSampling(const SSampling& sampling)
+{
+    if(sampling.every <= 1) return;
+
+    m_sampleEvery     = sampling.every;
+    m_sampleRandom    = sampling.random;
+    m_sampleThreshold = UINT32_MAX / sampling.every;
+    m_filtered        = true;
+
+    // Il generatore casuale parte da uno stato diverso per ogni connect (mai zero)
+    const std::uint32_t seed = static_cast<std::uint32_t>(hash() * 2654435761u) | 1u;
+#ifdef SOBJECT_THREAD_SAFE
+    m_sampleState.store(sampling.random ? seed : 0, std::memory_order_relaxed);
+#else
+    m_sampleState = sampling.random ? seed : 0;
+#endif
+}
+
+void _SlotCore::copyFilters(const _SlotCore& other)
+{
+    if(other.m_limiter != nullptr)
+    {
+        delete m_limiter;
+        m_limiter  = other.m_limiter->clone();
+        m_filtered = true;
+    }
+
+    if(other.m_sampleEvery != 0) setSampling(SSampling{ other.m_sampleEvery, other.m_sampleRandom });
+
+#ifdef SOBJECT_THREAD_SAFE
+    m_reads  = other.m_reads;
+    m_writes = other.m_writes;
+#endif
+}
+
+std::size_t _SlotCore::hash() const
+{
+    return std::hash<const void*>()(m_receiver) ^ (m_key.hash() * 31);
+}
+
+void _SlotCore::link(SObject* emitter, SModuleToken* module)
+{
+    setEmitter(emitter);
+
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        _SpinGuard guard(m_receiver->m_receiverLock);
+#endif
+        m_receiverEntry = m_receiver->m_slotToSignalObjectList.insert(m_receiver->m_slotToSignalObjectList.end(), this);
+        m_linked        = true;
+    }
+
+    if(module != nullptr)
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        _SpinGuard guard(module->m_lock);
+#endif
+        m_moduleEntry = module->m_slots.insert(module->m_slots.end(), this);
+        m_module      = module;
+    }
+}
+
+void _SlotCore::unlink(bool notify)
+{
+    // Le slot temporanee usate per i confronti non sono registrate
+    if(not m_linked) return;
+
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        _SpinGuard guard(m_receiver->m_receiverLock);
+#endif
+        m_receiver->m_slotToSignalObjectList.erase(m_receiverEntry);
+        m_linked = false;
+    }
+
+    if(m_module != nullptr)
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        _SpinGuard guard(m_module->m_lock);
+#endif
+        m_module->m_slots.erase(m_moduleEntry);
+        m_module = nullptr;
+    }
+
+    if(notify) m_receiver->connectionRemoved();
+}
+
+
+
+// =======================================
+//
+//              SignalBase
+//
+// =======================================
+
+namespace
+{
+
+// Prima posizione da from in poi che contiene il puntatore cercato (count se assente)
+std::size_t findPointerScalar(const SObject* const* array, std::size_t from, std::size_t count, const SObject* value)
+{
+    for(std::size_t index = from; index < count; ++index)
+    {
+        if(array[index] == value) return index;
+    }
+
+    return count;
+}
+
+#if defined(__x86_64__) and (defined(__GNUC__) or defined(__clang__))
+// Con AVX2 confronto quattro puntatori per istruzione e sedici per iterazione, unendo i risultati:
+// solo il blocco che contiene il puntatore viene esaminato elemento per elemento.
+// Compilata per AVX2 anche senza -mavx2, viene chiamata solo se la CPU lo supporta
+__attribute__((target("avx2")))
+std::size_t findPointerAvx2(const SObject* const* array, std::size_t from, std::size_t count, const SObject* value)
+{
+    const __m256i needle = _mm256_set1_epi64x(static_cast<long long>(reinterpret_cast<std::uintptr_t>(value)));
+    std::size_t index = from;
+
+    for(; index + 16 <= count; index += 16)
+    {
+        const __m256i* block = reinterpret_cast<const __m256i*>(array + index);
+        const __m256i equal0 = _mm256_cmpeq_epi64(_mm256_loadu_si256(block), needle);
+        const __m256i equal1 = _mm256_cmpeq_epi64(_mm256_loadu_si256(block + 1), needle);
+        const __m256i equal2 = _mm256_cmpeq_epi64(_mm256_loadu_si256(block + 2), needle);
+        const __m256i equal3 = _mm256_cmpeq_epi64(_mm256_loadu_si256(block + 3), needle);
+
+        const __m256i any = _mm256_or_si256(_mm256_or_si256(equal0, equal1), _mm256_or_si256(equal2, equal3));
+        if(_mm256_testz_si256(any, any)) continue;
+
+        return findPointerScalar(array, index, index + 16, value);
+    }
+
+    for(; index + 4 <= count; index += 4)
+    {
+        const __m256i equal = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(array + index)), needle);
+        const int mask = _mm256_movemask_pd(_mm256_castsi256_pd(equal));
+        if(mask != 0) return index + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+    }
+
+    return findPointerScalar(array, index, count, value);
+}
+#endif
+
+std::size_t findPointer(const std::vector<const SObject*>& array, std::size_t from, const SObject* value)
+{
+#if defined(__x86_64__) and (defined(__GNUC__) or defined(__clang__))
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if(avx2) return findPointerAvx2(array.data(), from, array.size(), value);
+#endif
+
+    return findPointerScalar(array.data(), from, array.size(), value);
+}
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+// Frazione di slot rimosse oltre la quale lo snapshot viene compattato: fino ad allora la disconnect
+// segna solo un bit e l'emit salta le slot rimosse a blocchi di 64
+const double tombstoneRatio = 0.5;
+
+std::size_t bitmapWords(std::size_t capacity)
+{
+    return (capacity + 63) / 64;
+}
+#endif
+
+}
+
+_SignalBase::_SignalBase(const _MethodKey& key) : m_key(key)
+{
+    std::fill(m_groupBegin, m_groupBegin + _GroupCount, m_slots.end());
+}
+
+_SignalBase::~_SignalBase()
+{
+    // Per ogni slot
+    for(auto slot : m_slots)
+    {
+        // Dealloco oggetto
+        delete slot;
+    }
+
+    for(auto slot : m_retainedSlots) delete slot;
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Il segnale viene eliminato dopo il ritiro, nessun emit legge più lo snapshot
+    for(auto slot : m_removedSlots) delete slot;
+    delete[] m_readSlots.load(std::memory_order_relaxed);
+    delete[] m_readRemoved.load(std::memory_order_relaxed);
+#endif
+
+    delete m_replay;
+
+    // Il flusso con radice nel segnale viene eliminato, quelli che lo attraversano invalidati
+    delete m_flow;
+    m_flow = nullptr;
+    invalidate();
+}
+
+void _SignalBase::setReplay(_ReplayBase* replay)
+{
+    delete m_replay;
+    m_replay = replay;
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // I segnali con replay vengono emessi con il lock
+    storeSnapshot(m_readSlots.load(std::memory_order_relaxed), m_readRemoved.load(std::memory_order_relaxed), m_readCount.load(std::memory_order_relaxed));
+#endif
+}
+
+void _SignalBase::setFlow(_Flow* flow)
+{
+    delete m_flow;
+    m_flow = flow;
+}
+
+void _SignalBase::addDependentFlow(_Flow* flow)
+{
+    m_dependentFlows.push_back(flow);
+}
+
+void _SignalBase::removeDependentFlow(_Flow* flow)
+{
+    m_dependentFlows.erase(std::remove(m_dependentFlows.begin(), m_dependentFlows.end(), flow), m_dependentFlows.end());
+}
+
+void _SignalBase::compile()
+{
+    if(m_compiled) return;
+
+    for(const _SlotCore* slot : m_slots)
+    {
+        if(slot->isSingleShot() or slot->isFiltered()) return;
+    }
+
+    m_program.clear();
+    m_program.reserve(m_slots.size());
+
+    for(auto slotIt = m_slots.begin(); slotIt != m_slots.end(); ++slotIt)
+    {
+        m_program.push_back({ slotIt, *slotIt, (*slotIt)->call() });
+    }
+
+    m_compiled = true;
+}
+
+void _SignalBase::addSlot(_SlotCore* slot)
+{
+    insertSlot(slot);
+
+    invalidate();
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Le slot dei gruppi pre e default possono finire in mezzo alla lista: in quel caso ricostruisco lo snapshot
+    if(std::next(slot->position()) == m_slots.end())
+    {
+        appendSnapshot(slot);
+    }
+    else
+    {
+        publishSnapshot();
+    }
+#endif
+}
+
+void _SignalBase::addSlots(const std::vector<_SlotCore*>& slots)
+{
+    for(auto slot : slots) insertSlot(slot);
+
+    invalidate();
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    publishSnapshot();
+#endif
+}
+
+bool _SignalBase::containsSlot(const _SlotCore* slot)
+{
+    // L'indice viene costruito solo alla prima connect unique del segnale
+    if(not m_indexed)
+    {
+        m_slotIndex.reserve(m_slots.size());
+        m_slotIndex.insert(m_slots.begin(), m_slots.end());
+        m_indexed = true;
+    }
+
+    return m_slotIndex.find(const_cast<_SlotCore*>(slot)) != m_slotIndex.end();
+}
+
+void _SignalBase::removeSlot(const _SlotCore* slot)
+{
+    // Tra le slot del receiver rimuovo quelle con lo stesso metodo
+    std::size_t index = 0;
+    while((index = findPointer(m_receivers, index, slot->getReceiver())) != m_receivers.size())
+    {
+        if(m_receiverSlots[index]->compareByPointer(slot))
+        {
+            removeReceiverAt(index);
+        }
+        else
+        {
+            ++index;
+        }
+    }
+}
+
+void _SignalBase::removeSlotByReceiver(const SObject* receiver)
+{
+    // Al posto di ogni slot rimossa va l'ultima voce dell'array, la scansione riprende dalla stessa posizione
+    std::size_t index = 0;
+    while((index = findPointer(m_receivers, index, receiver)) != m_receivers.size())
+    {
+        removeReceiverAt(index);
+    }
+}
+
+void _SignalBase::eraseSlot(_SlotCore* slot)
+{
+    eraseAt(slot->position());
+    unindexSlot(slot);
+    destroySlot(slot);
+}
+
+void _SignalBase::moveEmitter(SObject* emitter)
+{
+    for(auto slot : m_slots)
+    {
+        slot->setEmitter(emitter);
+    }
+
+    // I flussi riconoscono i passi tramite l'indirizzo dell'emitter, che ora appartiene all'oggetto spostato
+    invalidate();
+}
+
+void _SignalBase::moveReceiver(_SlotCore* slot, SObject* receiver)
+{
+    unindexSlot(slot);
+    slot->setReceiver(receiver);
+    m_receivers[slot->receiverIndex()] = receiver;
+    if(m_indexed) m_slotIndex.insert(slot);
+}
+
+void _SignalBase::removeAllSlots()
+{
+    const bool iterated = this->iterated();
+    if(not iterated) releaseRetained();
+
+    m_slotIndex.clear();
+    m_receivers.clear();
+    m_receiverSlots.clear();
+    m_singleShots = 0;
+
+    invalidate();
+
+    // Stacco tutte le slot (con SOBJECT_SEQLOCK_EMIT le segno anche nello snapshot)
+    for(auto slot : m_slots)
+    {
+        slotRemoved(slot);
+#ifdef SOBJECT_SEQLOCK_EMIT
+        markRemoved(slot);
+#endif
+        slot->unlink();
+
+        // Un emit in corso termina dopo la slot che sta chiamando
+        if(iterated) slot->setRemoved(m_slots.end());
+    }
+
+    if(iterated)
+    {
+        m_retainedSlots.splice(m_retainedSlots.end(), m_slots);
+    }
+    else
+    {
+#ifdef SOBJECT_SEQLOCK_EMIT
+        m_removedSlots.insert(m_removedSlots.end(), m_slots.begin(), m_slots.end());
+#else
+        for(auto slot : m_slots) delete slot;
+#endif
+        m_slots.clear();
+    }
+
+    std::fill(m_groupBegin, m_groupBegin + _GroupCount, m_slots.end());
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Pubblico lo snapshot vuoto, che ritira le slot rimosse insieme al vecchio array
+    publishSnapshot();
+#endif
+}
+
+void _SignalBase::destroySlot(_SlotCore* slot)
+{
+    // Slot trattenuta per un emit in corso: la stacco, verrà eliminata alla fine dell'emit
+    if(slot->isRemoved())
+    {
+        slot->unlink();
+        return;
+    }
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Un emit senza lock potrebbe ancora leggerla: la stacco subito, verrà ritirata alla compattazione
+    // dello snapshot, quando le slot rimosse superano tombstoneRatio dell'array (costo ammortizzato costante)
+    slot->unlink();
+
+    if(double(m_removedSlots.size()) > double(m_readCount.load(std::memory_order_relaxed)) * tombstoneRatio) publishSnapshot();
+#else
+    delete slot;
+#endif
+}
+
+void _SignalBase::dispose()
+{
+#ifdef SOBJECT_THREAD_SAFE
+    // Emit in corso: quelli del thread corrente e quelli degli altri thread fermi in attesa di un lock
+    const unsigned active = ownIterations(this, iterations.size()) + m_suspendedIterations.load(std::memory_order_relaxed) - ownIterations(this, publishedIterations);
+#else
+    const std::size_t active = m_iterations;
+#endif
+
+    // Le slot vengono staccate subito, il segnale resta in vita finché gli emit in corso non terminano
+    if(active != 0)
+    {
+        removeAllSlots();
+        m_orphaned = true;
+#ifdef SOBJECT_THREAD_SAFE
+        m_orphanIterations.store(active, std::memory_order_relaxed);
+#endif
+        return;
+    }
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Un emit senza lock potrebbe ancora leggerlo: stacco le slot e lo elimino quando nessun emit può più leggerlo
+    removeAllSlots();
+    _retireObject(this);
+#else
+    delete this;
+#endif
+}
+
+#ifdef SOBJECT_THREAD_SAFE
+void _SignalBase::beginIteration()
+{
+    iterations.push_back(this);
+}
+
+void _SignalBase::endIteration()
+{
+    iterations.pop_back();
+
+    // Segnale rimosso durante l'emit: l'ultimo emit che termina lo elimina
+    if(not m_orphaned or m_orphanIterations.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    _retireObject(this);
+#else
+    delete this;
+#endif
+}
+
+bool _SignalBase::iteratedElsewhere() const
+{
+    return m_suspendedIterations.load(std::memory_order_relaxed) != ownIterations(this, publishedIterations);
+}
+
+bool _SignalBase::iterated() const
+{
+    return m_suspendedIterations.load(std::memory_order_relaxed) != 0 or ownIterations(this, iterations.size()) != 0;
+}
+#endif
+
+void _SignalBase::releaseRetained()
+{
+    for(auto slot : m_retainedSlots)
+    {
+#ifdef SOBJECT_SEQLOCK_EMIT
+        // Gli emit senza lock possono ancora leggerle dallo snapshot: le ritira la prossima pubblicazione
+        m_removedSlots.push_back(slot);
+#else
+        delete slot;
+#endif
+    }
+
+    m_retainedSlots.clear();
+}
+
+std::uint64_t _SignalBase::droppedCount(const _SlotCore* slot) const
+{
+    std::uint64_t dropped = 0;
+
+    for(const _SlotCore* other : m_slots)
+    {
+        if(other->compareByPointer(slot)) dropped += other->droppedCount();
+    }
+
+    return dropped;
+}
+
+bool _SignalBase::connectedWithObject(const SObject* receiver) const
+{
+    // Controllo se ci sono slot del receiver
+    return findPointer(m_receivers, 0, receiver) != m_receivers.size();
+}
+
+std::list<SObject*> _SignalBase::getAllReceivers() const
+{
+    std::list<SObject*> list_t;
+
+    for(const _SlotCore* slot : m_slots)
+    {
+        list_t.push_back(slot->getReceiver());
+    }
+
+    return list_t;
+}
+
+_SignalBase::SlotList::iterator _SignalBase::detachAt(SlotList::iterator slotIt)
+{
+    _SlotCore* slot = *slotIt;
+
+    slotIt = eraseAt(slotIt);
+    unindexSlot(slot);
+
+    // La slot viene staccata per essere eseguita: non è una rimozione per il receiver
+    slot->unlink(false);
+
+    return slotIt;
+}
+
+void _SignalBase::removeReceiverAt(std::size_t index)
+{
+    _SlotCore* slot = m_receiverSlots[index];
+
+    eraseAt(slot->position());
+    unindexSlot(slot);
+    destroySlot(slot);
+}
+
+void _SignalBase::unlistReceiver(_SlotCore* slot)
+{
+    const std::size_t index = slot->receiverIndex();
+
+    m_receivers[index]     = m_receivers.back();
+    m_receiverSlots[index] = m_receiverSlots.back();
+    m_receiverSlots[index]->setReceiverIndex(index);
+
+    m_receivers.pop_back();
+    m_receiverSlots.pop_back();
+}
+
+void _SignalBase::unindexSlot(_SlotCore* slot)
+{
+    if(not m_indexed) return;
+
+    auto range = m_slotIndex.equal_range(slot);
+    for(auto indexIt = range.first; indexIt != range.second; ++indexIt)
+    {
+        if(*indexIt == slot)
+        {
+            m_slotIndex.erase(indexIt);
+            return;
+        }
+    }
+}
+
+_SignalBase::SlotList::iterator _SignalBase::insertSlot(_SlotCore* slot)
+{
+    if(not m_retainedSlots.empty() and not iterated()) releaseRetained();
+
+    const std::size_t group = slot->group();
+    const auto position = (group + 1 < _GroupCount) ? m_groupBegin[group + 1] : m_slots.end();
+    const auto slotIt = m_slots.insert(position, slot);
+    slot->place(this, slotIt, m_nextSerial++);
+
+    if(slot->isSingleShot()) ++m_singleShots;
+
+    slot->setReceiverIndex(m_receivers.size());
+    m_receivers.push_back(slot->getReceiver());
+    m_receiverSlots.push_back(slot);
+
+    // I gruppi vuoti che iniziavano nella posizione di inserimento ora iniziano dalla slot
+    for(std::size_t i = 0; i <= group; ++i)
+    {
+        if(m_groupBegin[i] == position) m_groupBegin[i] = slotIt;
+    }
+
+    if(m_indexed)
+    {
+        m_slotIndex.insert(slot);
+    }
+
+    return slotIt;
+}
+
+_SignalBase::SlotList::iterator _SignalBase::eraseAt(SlotList::iterator slotIt)
+{
+    _SlotCore* slot = *slotIt;
+    const auto next = std::next(slotIt);
+
+    const bool iterated = this->iterated();
+    if(not iterated and not m_retainedSlots.empty()) releaseRetained();
+
+    if(slot->isSingleShot()) --m_singleShots;
+    unlistReceiver(slot);
+
+    for(std::size_t i = 0; i < _GroupCount; ++i)
+    {
+        if(m_groupBegin[i] == slotIt) m_groupBegin[i] = next;
+    }
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    markRemoved(slot);
+#endif
+
+    slotRemoved(slot);
+    invalidate();
+
+    // Un emit in corso può essere fermo sulla slot: la sposto tra quelle trattenute (il nodo
+    // resta valido) e le faccio ricordare la slot successiva, da cui l'emit riprende
+    if(iterated)
+    {
+        slot->setRemoved(next);
+        m_retainedSlots.splice(m_retainedSlots.end(), m_slots, slotIt);
+        return next;
+    }
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    m_removedSlots.push_back(slot);
+#endif
+
+    return m_slots.erase(slotIt);
+}
+
+void _SignalBase::invalidate()
+{
+    m_compiled = false;
+    m_program.clear();
+    ++m_version;
+
+    if(m_dependentFlows.empty()) return;
+
+    // Ogni flusso invalidato si rimuove dai propri segnali, scorro una copia della lista
+    std::vector<_Flow*> flows;
+    flows.swap(m_dependentFlows);
+
+    for(_Flow* flow : flows)
+    {
+        flow->invalidate();
+    }
+}
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+void _SignalBase::publishSnapshot()
+{
+    const std::size_t count = m_slots.size();
+
+    // Lascio spazio per le connect in coda, che non devono riallocare l'array
+    _SlotCore** slots = nullptr;
+    std::atomic<std::uint64_t>* removed = nullptr;
+    _SlotCore** previous = m_readSlots.load(std::memory_order_relaxed);
+    std::atomic<std::uint64_t>* previousRemoved = m_readRemoved.load(std::memory_order_relaxed);
+
+    if(count != 0)
+    {
+        m_readCapacity = std::max<std::size_t>(8, count * 2);
+        slots = new _SlotCore*[m_readCapacity];
+
+        // Bitmap delle slot rimosse, vuota: la compattazione toglie dall'array tutte quelle segnate
+        removed = new std::atomic<std::uint64_t>[bitmapWords(m_readCapacity)];
+        for(std::size_t i = 0; i < bitmapWords(m_readCapacity); ++i) removed[i].store(0, std::memory_order_relaxed);
+
+        std::size_t index = 0;
+        for(auto slot : m_slots)
+        {
+            slot->setSnapshotIndex(index);
+            slots[index++] = slot;
+        }
+    }
+    else
+    {
+        m_readCapacity = 0;
+    }
+
+    storeSnapshot(slots, removed, count);
+
+    // Da qui in poi nessun nuovo emit vede il vecchio array e le slot rimosse
+    if(previous != nullptr) _retireArray(previous);
+    if(previousRemoved != nullptr) _retireArray(previousRemoved);
+
+    for(auto slot : m_removedSlots) _retireObject(slot);
+    m_removedSlots.clear();
+}
+
+void _SignalBase::appendSnapshot(_SlotCore* slot)
+{
+    _SlotCore** slots = m_readSlots.load(std::memory_order_relaxed);
+    const std::size_t count = m_readCount.load(std::memory_order_relaxed);
+
+    if(count == m_readCapacity)
+    {
+        publishSnapshot();
+        return;
+    }
+
+    // L'elemento oltre m_readCount non è letto da nessun emit finché non pubblico il nuovo numero
+    slots[count] = slot;
+    slot->setSnapshotIndex(count);
+    storeSnapshot(slots, m_readRemoved.load(std::memory_order_relaxed), count + 1);
+}
+
+void _SignalBase::markRemoved(_SlotCore* slot)
+{
+    // Un solo scrittore alla volta (lock esclusivo): load e store senza RMW
+    const std::size_t index = slot->snapshotIndex();
+    std::atomic<std::uint64_t>& word = m_readRemoved.load(std::memory_order_relaxed)[index / 64];
+    word.store(word.load(std::memory_order_relaxed) | (std::uint64_t(1) << (index % 64)), std::memory_order_relaxed);
+
+    // Togliendo l'ultima slot single shot il segnale torna all'emit senza lock
+    const bool locked = m_singleShots != 0 or m_replay != nullptr;
+    if(locked != m_readLocked.load(std::memory_order_relaxed))
+    {
+        storeSnapshot(m_readSlots.load(std::memory_order_relaxed), m_readRemoved.load(std::memory_order_relaxed), m_readCount.load(std::memory_order_relaxed));
+    }
+}
+
+void _SignalBase::storeSnapshot(_SlotCore** slots, std::atomic<std::uint64_t>* removed, std::size_t count)
+{
+    const unsigned sequence = m_sequence.load(std::memory_order_relaxed);
+
+    // Sequenza dispari durante la scrittura: i lettori che la incontrano riprovano
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_readSlots.store(slots, std::memory_order_relaxed);
+    m_readRemoved.store(removed, std::memory_order_relaxed);
+    m_readCount.store(count, std::memory_order_relaxed);
+    m_readLocked.store(m_singleShots != 0 or m_replay != nullptr, std::memory_order_relaxed);
+
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+#endif
+
+
+
+// =======================================
+//
+//                Flow
+//
+// =======================================
+
+namespace
+{
+thread_local _Flow* activeFlow = nullptr;
+}
+
+_Flow::~_Flow()
+{
+    if(activeFlow == this) activeFlow = nullptr;
+
+    invalidate();
+}
+
+_Flow* _Flow::active()
+{
+    return activeFlow;
+}
+
+_SignalBase* _Flow::resolve(const SObject* emitter, const _MethodKey& key)
+{
+    if(m_state == Recording)
+    {
+        _SignalBase* signal = emitter->findSignal(key);
+        m_steps.push_back({ emitter, key, signal });
+        if(signal != nullptr) depend(signal);
+        return signal;
+    }
+
+    if(m_state == Valid)
+    {
+        if(m_cursor < m_steps.size() and m_steps[m_cursor].emitter == emitter and m_steps[m_cursor].key == key)
+        {
+            _SignalBase* signal = m_steps[m_cursor++].signal;
+            if(signal != nullptr) return signal;
+
+            // L'emitter non aveva il segnale: se ora esiste la cascata è cambiata
+            signal = emitter->findSignal(key);
+            if(signal != nullptr) invalidate();
+            return signal;
+        }
+
+        // La cascata non segue il programma (es. emit condizionale)
+        invalidate();
+    }
+
+    return emitter->findSignal(key);
+}
+
+void _Flow::invalidate()
+{
+    for(_SignalBase* signal : m_signals)
+    {
+        signal->removeDependentFlow(this);
+    }
+
+    m_signals.clear();
+    m_steps.clear();
+    m_state = Invalid;
+}
+
+void _Flow::begin()
+{
+    activeFlow = this;
+    m_cursor   = 0;
+
+    if(m_state == Invalid)
+    {
+        m_state = Recording;
+        depend(m_root);
+    }
+}
+
+void _Flow::end()
+{
+    activeFlow = nullptr;
+
+    if(m_state == Recording)
+    {
+        // Compilo i programmi di tutti i segnali attraversati
+        for(_SignalBase* signal : m_signals)
+        {
+            signal->compile();
+        }
+
+        m_state = Valid;
+    }
+    else if(m_state == Valid and m_cursor != m_steps.size())
+    {
+        invalidate();
+    }
+}
+
+void _Flow::depend(_SignalBase* signal)
+{
+    if(std::find(m_signals.begin(), m_signals.end(), signal) != m_signals.end()) return;
+
+    m_signals.push_back(signal);
+    signal->addDependentFlow(this);
+}
+
+
+
+
+// =======================================
+//
+//            ArraySignal
+//
+// =======================================
+
+void _ArraySignalBase::addElementSlot(std::size_t element, _SlotCore* slot)
+{
+    m_elementOf[slot] = static_cast<std::uint32_t>(element);
+    m_elementSlots[static_cast<std::uint32_t>(element)].push_back(slot);
+    addSlot(slot);
+}
+
+bool _ArraySignalBase::containsElementSlot(std::size_t element, const _SlotCore* slot) const
+{
+    const auto elementSlots = m_elementSlots.find(static_cast<std::uint32_t>(element));
+    if(elementSlots == m_elementSlots.end()) return false;
+
+    for(const _SlotCore* other : elementSlots->second)
+    {
+        if(other->compareByPointer(slot)) return true;
+    }
+
+    return false;
+}
+
+void _ArraySignalBase::removeElementSlot(std::size_t element, const _SlotCore* slot)
+{
+    const auto elementSlots = m_elementSlots.find(static_cast<std::uint32_t>(element));
+    if(elementSlots == m_elementSlots.end()) return;
+
+    // Copio le slot da eliminare: ogni eliminazione le toglie dall'indice (e la propria voce dal receiver)
+    std::vector<_SlotCore*> removed;
+    for(_SlotCore* other : elementSlots->second)
+    {
+        if(other->compareByPointer(slot)) removed.push_back(other);
+    }
+
+    for(_SlotCore* other : removed) eraseSlot(other);
+}
+
+void _ArraySignalBase::removeElementsFrom(std::size_t first)
+{
+    std::vector<_SlotCore*> removed;
+    for(_SlotCore* slot : m_slots)
+    {
+        if(m_elementOf.at(slot) >= first) removed.push_back(slot);
+    }
+
+    for(_SlotCore* slot : removed) eraseSlot(slot);
+}
+
+void _ArraySignalBase::slotRemoved(_SlotCore* slot)
+{
+    const auto elementOf = m_elementOf.find(slot);
+    if(elementOf == m_elementOf.end()) return;
+
+    const auto elementSlots = m_elementSlots.find(elementOf->second);
+    std::vector<_SlotCore*>& slots = elementSlots->second;
+    slots.erase(std::find(slots.begin(), slots.end(), slot));
+    if(slots.empty()) m_elementSlots.erase(elementSlots);
+
+    m_elementOf.erase(elementOf);
+}
+
+void _ArraySignalBase::rebuild()
+{
+    // Ordino le slot per elemento mantenendo l'ordine della lista (gruppi pre, default e post)
+    std::vector<std::pair<std::uint32_t, _SlotCore*>> entries;
+    entries.reserve(m_slots.size());
+    for(_SlotCore* slot : m_slots) entries.emplace_back(m_elementOf.at(slot), slot);
+
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const std::pair<std::uint32_t, _SlotCore*>& first, const std::pair<std::uint32_t, _SlotCore*>& second) { return first.first < second.first; });
+
+    m_tableElements.clear();
+    m_tableSlots.clear();
+    m_tableCalls.clear();
+    m_tableElements.reserve(entries.size());
+    m_tableSlots.reserve(entries.size());
+    m_tableCalls.reserve(entries.size());
+
+    for(const auto& entry : entries)
+    {
+        // Le slot filtrate o accodate passano da exec, le altre sono chiamate dirette
+        _SlotCore* slot = entry.second;
+        m_tableElements.push_back(entry.first);
+        m_tableSlots.push_back(slot);
+        m_tableCalls.push_back(slot->isFiltered() or slot->isDeferred() ? execCall() : slot->call());
+    }
+
+    m_tableVersion = m_version;
+    m_tableValid   = true;
+}
+
+
+
+// =======================================
+//
+//               Prefab
+//
+// =======================================
+
+_Prefab::_Prefab(std::initializer_list<SObject*> objects) : m_objects(objects.size())
+{
+    const std::vector<SObject*> list(objects);
+
+    for(std::size_t emitter = 0; emitter < list.size(); ++emitter)
+    {
+        _StripeReadLock readLock(list[emitter]);
+
+        for(const _SignalBase* signal : list[emitter]->m_signalsList)
+        {
+            Group group{ emitter, nullptr, {}, {} };
+
+            // Catturo solo le connect verso oggetti del gruppo, nell'ordine della lista (gruppi pre, default e post)
+            for(const _SlotCore* slot : signal->slots())
+            {
+                const auto receiver = std::find(list.begin(), list.end(), slot->getReceiver());
+                if(receiver == list.end()) continue;
+
+                group.slots.push_back(slot->clone(nullptr));
+                group.receivers.push_back(receiver - list.begin());
+            }
+
+            if(group.slots.empty()) continue;
+
+            group.prototype = signal->cloneEmpty();
+            m_connections += group.slots.size();
+            m_groups.push_back(std::move(group));
+        }
+    }
+}
+
+_Prefab::~_Prefab()
+{
+    for(Group& group : m_groups)
+    {
+        for(_SlotCore* slot : group.slots) delete slot;
+        delete group.prototype;
+    }
+}
+
+void _Prefab::instantiate(std::initializer_list<SObject*> objects) const
+{
+    const std::vector<SObject*> list(objects);
+    if(list.size() != m_objects) return;
+
+    // Un solo lock esclusivo per tutti gli emitter dell'istanza
+    std::uint64_t mask = 0;
+    for(const Group& group : m_groups) mask |= _stripeMask(list[group.emitter]);
+    _StripeWriteLock writeLock(mask);
+
+    std::vector<_SlotCore*> slots;
+    for(const Group& group : m_groups)
+    {
+        SObject* emitter = list[group.emitter];
+
+        _SignalBase* signal = emitter->findSignal(group.prototype->key());
+        if(signal == nullptr)
+        {
+            signal = group.prototype->cloneEmpty();
+            emitter->m_signalsList.push_back(signal);
+#ifdef SOBJECT_SEQLOCK_EMIT
+            emitter->publishSignals();
+#endif
+        }
+
+        slots.clear();
+        for(std::size_t i = 0; i < group.slots.size(); ++i) slots.push_back(group.slots[i]->clone(list[group.receivers[i]]));
+
+        signal->addSlots(slots);
+        for(_SlotCore* slot : slots) slot->link(emitter);
+    }
+}
+
+} // namespace _sobject
+
+
+
+
+
+
+
+
+
+// =======================================
+//
+//               SObject
+//
+// =======================================
+
+SObject::SObject(SObject&& other)
+{
+    takeConnections(other);
+}
+
+SObject& SObject::operator=(SObject&& other)
+{
+    if(&other == this) return *this;
+
+    // Le connect dell'oggetto vengono rimosse e sostituite da quelle di other
+    releaseConnections();
+    takeConnections(other);
+
+    return *this;
+}
+
+SObject::~SObject()
+{
+    releaseConnections();
+}
+
+void SObject::releaseConnections()
+{
+#ifdef SOBJECT_THREAD_SAFE
+    // I task già accodati verso l'oggetto non chiameranno più le sue slot
+    if(std::shared_ptr<_sobject::_LoopState> state = std::atomic_load(&m_loopState)) state->alive.store(false, std::memory_order_release);
+
+    // Tolgo l'oggetto dal registro del suo shard
+    if(_sobject::_EventShard* shard = m_shard.exchange(nullptr, std::memory_order_acq_rel)) _sobject::_registerObject(shard, this, false);
+#endif
+
+    // Slego l'oggetto dal grafo statico
+    if(m_staticGraph != nullptr) m_staticGraph->unbind(this);
+    m_staticGraph = nullptr;
+
+#ifdef SOBJECT_THREAD_SAFE
+    // Un emit dell'oggetto può essere fermo in attesa di un lock (una sua slot fa connect o emit
+    // su altri oggetti) e usa ancora l'oggetto: aspetto che termini, rilasciando lo stripe a ogni tentativo
+    for(;;)
+    {
+        {
+            _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(this));
+
+            if(std::none_of(m_signalsList.begin(), m_signalsList.end(), [](const _sobject::_SignalBase* signal) { return signal->iteratedElsewhere(); }))
+            {
+                // Effettuo il reset delle connect, elimino anche i segnali mantenuti per il replay
+                removeAllSignal(false);
+                break;
+            }
+        }
+
+        std::this_thread::yield();
+    }
+#else
+    {
+        // Effettuo il reset delle connect, elimino anche i segnali mantenuti per il replay
+        removeAllSignal(false);
+    }
+#endif
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    bool receiver = false;
+    {
+        _sobject::_SpinGuard guard(m_receiverLock);
+        receiver = not m_slotToSignalObjectList.empty();
+    }
+#endif
+
+    // Finché esiste un SObject che ha una connect con il seguente oggetto
+    // (ogni slot rimossa elimina la propria voce dalla lista)
+    for(;;)
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        // Blocco gli stripe di tutti gli emitter, in ordine di indirizzo.
+        // Un emitter resta vivo finché ha una slot verso l'oggetto, e non può eliminarla senza il suo stripe
+        const std::uint64_t mask = emitterMask();
+        if(mask == 0) break;
+
+        bool busy = false;
+        {
+            _sobject::_StripeWriteLock writeLock(mask);
+
+            // Un emit fermo in attesa di un lock può essere dentro una slot dell'oggetto: aspetto che termini
+            {
+                _sobject::_SpinGuard guard(m_receiverLock);
+                busy = std::any_of(m_slotToSignalObjectList.begin(), m_slotToSignalObjectList.end(), [mask](const _sobject::_SlotCore* slot)
+                                   {
+                                       const SObject* emitter = slot->emitter();
+                                       return (_sobject::_stripeMask(emitter) & mask) and
+                                              std::any_of(emitter->m_signalsList.begin(), emitter->m_signalsList.end(), [](const _sobject::_SignalBase* signal) { return signal->iteratedElsewhere(); });
+                                   });
+            }
+
+            // Rimuovo le connect degli emitter coperti dai lock, gli altri (connessi nel frattempo) al prossimo giro
+            while(not busy)
+            {
+                SObject* sObject = nullptr;
+                {
+                    _sobject::_SpinGuard guard(m_receiverLock);
+                    for(const _sobject::_SlotCore* slot : m_slotToSignalObjectList)
+                    {
+                        if(_sobject::_stripeMask(slot->emitter()) & mask)
+                        {
+                            sObject = slot->emitter();
+                            break;
+                        }
+                    }
+                }
+
+                if(sObject == nullptr) break;
+                for(auto signal : sObject->m_signalsList) signal->removeSlotByReceiver(this);
+            }
+        }
+
+        if(busy) std::this_thread::yield();
+#else
+        if(m_slotToSignalObjectList.empty()) break;
+
+        SObject* sObject = m_slotToSignalObjectList.front()->emitter();
+
+        // Per ogni segnale di tale oggetto
+        for(auto signal : sObject->m_signalsList)
+        {
+            signal->removeSlotByReceiver(this);
+        }
+#endif
+    }
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Un emit senza lock iniziato prima della disconnect può ancora chiamare le slot dell'oggetto:
+    // aspetto che termini prima di liberarne la memoria. Dentro un emit non posso aspettare
+    // (il thread stesso potrebbe essere tra quelli in corso), resta a carico del chiamante
+    if(receiver and not _sobject::_inEpoch()) _sobject::_synchronize();
+#endif
+}
+
+void SObject::takeConnections(SObject& other)
+{
+#ifdef SOBJECT_THREAD_SAFE
+    // Blocco gli stripe dei due oggetti e degli emitter connessi a other.
+    // Se nel frattempo un nuovo emitter si è connesso a other allargo la maschera e riprovo
+    std::uint64_t mask = _sobject::_stripeMask(this) | _sobject::_stripeMask(&other);
+    for(;;)
+    {
+        mask |= other.emitterMask();
+
+        _sobject::_StripeWriteLock writeLock(mask);
+        if((other.emitterMask() & ~mask) != 0) continue;
+
+        moveConnections(other);
+        return;
+    }
+#else
+    moveConnections(other);
+#endif
+}
+
+void SObject::moveConnections(SObject& other)
+{
+    // Segnali: le liste delle slot restano le stesse, cambia solo l'emitter salvato in ogni slot
+    m_signalsList.swap(other.m_signalsList);
+    for(auto signal : m_signalsList) signal->moveEmitter(this);
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // La tabella dell'oggetto è vuota (oggetto nuovo o connect rimosse dall'assegnamento), prendo quella di other
+    m_signalTable.store(other.m_signalTable.exchange(nullptr, std::memory_order_acq_rel), std::memory_order_release);
+#endif
+
+    // Connect in cui other è receiver: aggiorno il receiver di ogni slot e sposto le voci in blocco
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        _sobject::_SpinGuard otherGuard(other.m_receiverLock);
+        _sobject::_SpinGuard guard(m_receiverLock);
+#endif
+        for(auto slot : other.m_slotToSignalObjectList) slot->signal()->moveReceiver(slot, this);
+        m_slotToSignalObjectList.splice(m_slotToSignalObjectList.end(), other.m_slotToSignalObjectList);
+    }
+
+    // Grafo statico
+    if(other.m_staticGraph != nullptr) other.m_staticGraph->rebind(&other, this);
+    m_staticGraph       = other.m_staticGraph;
+    other.m_staticGraph = nullptr;
+
+#ifdef SOBJECT_THREAD_SAFE
+    // I task accodati verso other contengono il suo indirizzo: vengono scartati.
+    // L'oggetto spostato resta sullo shard con un nuovo flag di vita
+    if(std::shared_ptr<_sobject::_LoopState> state = std::atomic_exchange(&other.m_loopState, std::shared_ptr<_sobject::_LoopState>()))
+    {
+        state->alive.store(false, std::memory_order_release);
+    }
+
+    _sobject::_EventShard* shard = other.m_shard.exchange(nullptr, std::memory_order_acq_rel);
+    std::shared_ptr<_sobject::_LoopState> state;
+    if(shard != nullptr)
+    {
+        state = std::make_shared<_sobject::_LoopState>();
+        state->shard.store(shard, std::memory_order_relaxed);
+
+        _sobject::_registerObject(shard, &other, false);
+        _sobject::_registerObject(shard, this, true);
+    }
+    std::atomic_store(&m_loopState, state);
+    m_shard.store(shard, std::memory_order_release);
+#endif
+}
+
+#ifdef SOBJECT_THREAD_SAFE
+std::uint64_t SObject::emitterMask()
+{
+    _sobject::_SpinGuard guard(m_receiverLock);
+
+    std::uint64_t mask = 0;
+    for(const _sobject::_SlotCore* slot : m_slotToSignalObjectList) mask |= _sobject::_stripeMask(slot->emitter());
+    return mask;
+}
+#endif
+
+bool SObject::connectedWithObject(SObject* receiver) const
+{
+    _sobject::_StripeReadLock readLock(this);
+
+    // Per ogni segnale
+    for(auto signal : m_signalsList)
+    {
+        if(signal->connectedWithObject(receiver))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::list<SObject*> SObject::getAllReceivers(_sobject::_SignalBase* signalIn) const
+{
+    _sobject::_StripeReadLock readLock(this);
+
+    // Creo la lista dei ricevitori
+    std::list<SObject*> allReceiver;
+
+    // Per ogni segnale
+    for(const _sobject::_SignalBase* signal : m_signalsList)
+    {
+        // Se si vogliono i receiver di un solo signal controllo se è quello in input
+        if(signal == nullptr or (signalIn != nullptr and not signal->compareByPointer(signalIn))) continue;
+
+        // Recupero tutti i receiver del segnale
+        std::list<SObject*> signalReceivers = signal->getAllReceivers();
+
+        // Salvo tutti i receiver di questo segnale
+        allReceiver.insert(allReceiver.begin(), signalReceivers.begin(), signalReceivers.end());
+    }
+
+    // Ordino tutti i receiver (per poi chiamare unique)
+    allReceiver.sort();
+
+    // Chiamo unique ed elimino le ripetizioni
+    auto _allReceiver = std::unique(allReceiver.begin(), allReceiver.end());
+    allReceiver.erase(_allReceiver, allReceiver.end());
+
+    return allReceiver;
+}
+
+_sobject::_SignalBase* SObject::findSignal(const _sobject::_MethodKey& key) const
+{
+    for(_sobject::_SignalBase* signal : m_signalsList)
+    {
+        if(signal->compareByKey(key)) return signal;
+    }
+
+    return nullptr;
+}
+
+void SObject::removeSignal(const _sobject::_MethodKey& key)
+{
+    auto emitterSignal = std::find_if(m_signalsList.begin(), m_signalsList.end(),
+                                      [&key](const _sobject::_SignalBase* signal) { return signal->compareByKey(key); });
+    if(emitterSignal == m_signalsList.end()) return;
+
+    if((*emitterSignal)->isPersistent())
+    {
+        (*emitterSignal)->removeAllSlots();
+    }
+    else
+    {
+        _sobject::_SignalBase* signal = *emitterSignal;
+        m_signalsList.erase(emitterSignal);
+
+        destroySignal(signal);
+    }
+}
+
+void SObject::removeAllSignal(bool keepPersistent)
+{
+    // Per ogni segnale
+    for(auto signalIt = m_signalsList.begin(); signalIt != m_signalsList.end();)
+    {
+        // I segnali con replay o flusso perdono solo le slot per non perdere lo stato
+        if(keepPersistent and (*signalIt)->isPersistent())
+        {
+            (*signalIt)->removeAllSlots();
+            ++signalIt;
+            continue;
+        }
+
+        // Elimino segnale (se un emit lo sta scorrendo verrà eliminato alla sua fine)
+        _sobject::_SignalBase* signal = *signalIt;
+        signalIt = m_signalsList.erase(signalIt);
+        destroySignal(signal);
+    }
+}
+
+void SObject::destroySignal(_sobject::_SignalBase* signal)
+{
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Il segnale è già fuori da m_signalsList: pubblico la nuova tabella prima di eliminarlo
+    publishSignals();
+#endif
+
+    // Se un emit lo sta scorrendo verrà eliminato alla sua fine
+    signal->dispose();
+}
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+void SObject::publishSignals()
+{
+    _sobject::_SignalTable* table = nullptr;
+    if(not m_signalsList.empty())
+    {
+        table = new _sobject::_SignalTable;
+        table->signals.assign(m_signalsList.begin(), m_signalsList.end());
+    }
+
+    const _sobject::_SignalTable* previous = m_signalTable.exchange(table, std::memory_order_acq_rel);
+    if(previous != nullptr) _sobject::_retireObject(previous);
+}
+#endif
+
+
+
+
+
+
+
+
+
+// =======================================
+//
+//             Disconnect
+//
+// =======================================
+
+void disconnect(SObject* emitter)
+{
+    _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(emitter));
+
+    // Rimuovo tutte le connect dall'emitter (le slot eliminate si rimuovono dai receiver)
+    emitter->removeAllSignal();
+}
+
+void disconnectModule(SModuleToken& module)
+{
+#ifdef SOBJECT_SEQLOCK_EMIT
+    bool removed = false;
+#endif
+
+    // Ogni slot eliminata rimuove la propria voce dal modulo e dal receiver
+    for(;;)
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        // Leggo l'emitter della prima slot, poi con il suo stripe controllo che la slot sia ancora la prima
+        SObject* emitter = nullptr;
+        {
+            _sobject::_SpinGuard guard(module.m_lock);
+            if(module.m_slots.empty()) break;
+            emitter = module.m_slots.front()->emitter();
+        }
+
+        _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(emitter));
+
+        _sobject::_SlotCore* slot = nullptr;
+        {
+            _sobject::_SpinGuard guard(module.m_lock);
+            if(not module.m_slots.empty() and module.m_slots.front()->emitter() == emitter) slot = module.m_slots.front();
+        }
+
+        if(slot == nullptr) continue;
+
+        slot->signal()->eraseSlot(slot);
+#ifdef SOBJECT_SEQLOCK_EMIT
+        removed = true;
+#endif
+#else
+        if(module.m_slots.empty()) break;
+
+        _sobject::_SlotCore* slot = module.m_slots.front();
+        slot->signal()->eraseSlot(slot);
+#endif
+    }
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Gli emit senza lock non prendono lo stripe: uno iniziato prima della rimozione può ancora eseguire
+    // una slot del modulo. Aspetto che termini, così al ritorno il codice del modulo può essere scaricato.
+    // Dentro un emit non posso aspettare (come in releaseConnections), resta a carico del chiamante
+    if(removed and not _sobject::_inEpoch()) _sobject::_synchronize();
+#endif
+}
+
+
+
+// =======================================
+//
+//               Rewire
+//
+// =======================================
+
+namespace
+{
+// Connect identificate da receiver, slot e tipo (il segnale è quello in cui si trovano)
+struct EdgeHash
+{
+    std::size_t operator()(const _sobject::_SlotCore* slot) const
+    {
+        return slot->hash() ^ static_cast<std::size_t>(slot->type());
+    }
+};
+
+struct EdgeEqual
+{
+    bool operator()(const _sobject::_SlotCore* first, const _sobject::_SlotCore* second) const
+    {
+        return first->compareByPointer(second) and first->type() == second->type();
+    }
+};
+
+typedef std::unordered_set<const _sobject::_SlotCore*, EdgeHash, EdgeEqual> EdgeSet;
+}
+
+SWiring::~SWiring()
+{
+    clear();
+}
+
+void SWiring::include(SObject* emitter)
+{
+    emitterFor(emitter);
+}
+
+void SWiring::clear()
+{
+    for(Emitter& emitter : m_emitters)
+    {
+        for(Signal& signal : emitter.signals)
+        {
+            for(_sobject::_SlotCore* slot : signal.slots) delete slot;
+        }
+    }
+
+    m_emitters.clear();
+    m_index.clear();
+}
+
+SWiring::Emitter& SWiring::emitterFor(SObject* emitter)
+{
+    const auto found = m_index.find(emitter);
+    if(found != m_index.end()) return m_emitters[found->second];
+
+    m_index.emplace(emitter, m_emitters.size());
+    m_emitters.push_back({ emitter, {} });
+    return m_emitters.back();
+}
+
+SWiring::Signal& SWiring::signalFor(SObject* emitter, const _sobject::_MethodKey& key, _sobject::_SignalFactory factory)
+{
+    Emitter& entry = emitterFor(emitter);
+    for(Signal& signal : entry.signals)
+    {
+        if(signal.key == key) return signal;
+    }
+
+    entry.signals.push_back({ key, factory, {} });
+    return entry.signals.back();
+}
+
+void SWiring::apply(const Emitter& entry, SRewireResult& result) const
+{
+    SObject* emitter = entry.object;
+
+    // Con il lock condiviso cerco le connect desiderate che mancano
+    std::vector<const _sobject::_SlotCore*> missing;
+    {
+        _sobject::_StripeReadLock readLock(emitter);
+
+        for(const Signal& signal : entry.signals)
+        {
+            EdgeSet live;
+            if(const _sobject::_SignalBase* current = emitter->findSignal(signal.key)) live.insert(current->slots().begin(), current->slots().end());
+
+            for(const _sobject::_SlotCore* slot : signal.slots)
+            {
+                if(live.insert(slot).second) missing.push_back(slot);
+            }
+        }
+    }
+
+    // Alloco le nuove slot senza lock
+    std::unordered_map<const _sobject::_SlotCore*, _sobject::_SlotCore*> prepared;
+    for(const _sobject::_SlotCore* slot : missing) prepared.emplace(slot, slot->clone(slot->getReceiver()));
+
+    {
+        // Con il lock esclusivo ripeto il confronto (le connect possono essere cambiate nel frattempo)
+        _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(emitter));
+
+        // I segnali assenti dall'insieme perdono tutte le connect
+        std::vector<_sobject::_MethodKey> dropped;
+        for(const _sobject::_SignalBase* signal : emitter->m_signalsList)
+        {
+            if(signal->slots().empty()) continue;
+
+            const bool wanted = std::any_of(entry.signals.begin(), entry.signals.end(),
+                                            [signal](const Signal& desired) { return signal->compareByKey(desired.key); });
+            if(not wanted)
+            {
+                dropped.push_back(signal->key());
+                result.removed += signal->slots().size();
+            }
+        }
+
+        for(const _sobject::_MethodKey& key : dropped) emitter->removeSignal(key);
+
+        for(const Signal& signal : entry.signals)
+        {
+            _sobject::_SignalBase* current = emitter->findSignal(signal.key);
+
+            // Ogni connect desiderata trattiene una sola connect attuale uguale, le altre vengono rimosse
+            EdgeSet desired(signal.slots.begin(), signal.slots.end());
+            if(current != nullptr)
+            {
+                std::vector<_sobject::_SlotCore*> removed;
+                for(_sobject::_SlotCore* slot : current->slots())
+                {
+                    if(desired.erase(slot) == 0) removed.push_back(slot);
+                }
+
+                for(_sobject::_SlotCore* slot : removed) current->eraseSlot(slot);
+                result.removed += removed.size();
+            }
+
+            if(desired.empty()) continue;
+
+            if(current == nullptr)
+            {
+                current = signal.factory(signal.key);
+                emitter->m_signalsList.push_back(current);
+#ifdef SOBJECT_SEQLOCK_EMIT
+                emitter->publishSignals();
+#endif
+            }
+
+            // Le connect rimaste mancano: le aggiungo nell'ordine dell'insieme, con le slot già allocate
+            std::vector<_sobject::_SlotCore*> added;
+            for(const _sobject::_SlotCore* slot : signal.slots)
+            {
+                const auto desiredIt = desired.find(slot);
+                if(desiredIt == desired.end() or *desiredIt != slot) continue;
+
+                const auto preparedIt = prepared.find(slot);
+                if(preparedIt != prepared.end() and preparedIt->second != nullptr)
+                {
+                    added.push_back(preparedIt->second);
+                    preparedIt->second = nullptr;
+                }
+                else
+                {
+                    added.push_back(slot->clone(slot->getReceiver()));
+                }
+            }
+
+            current->addSlots(added);
+            result.added += added.size();
+
+            for(_sobject::_SlotCore* slot : added) slot->link(emitter);
+
+            // Come nella connect, consegno i valori già emessi alle connect con replay. Le slot e il segnale
+            // restano validi anche se una slot li rimuove, le slot già rimosse non ricevono il replay
+            _sobject::_IterationScope scope(current);
+            for(_sobject::_SlotCore* slot : added)
+            {
+                const SConnectionType type = slot->type();
+                if(not (type & (SReplayLastConnection | SReplayAllConnection)) or slot->isRemoved()) continue;
+
+                if(current->replay(slot, slot->isSingleShot() or not (type & SReplayAllConnection)) and slot->isSingleShot() and not slot->isRemoved())
+                {
+                    current->eraseSlot(slot);
+                }
+            }
+        }
+    }
+
+    // Slot preparate ma non più necessarie (connect aggiunte da altri thread nel frattempo)
+    for(const auto& entryIt : prepared) delete entryIt.second;
+}
+
+SRewireResult rewire(const SWiring& wiring)
+{
+    SRewireResult result{ 0, 0 };
+    for(const SWiring::Emitter& emitter : wiring.m_emitters) wiring.apply(emitter, result);
+
+    return result;
+}
+
+
+
+
+
+
+
+
+
+// =======================================
+//
+//             ModuleToken
+//
+// =======================================
+
+SModuleToken::~SModuleToken()
+{
+    disconnectModule(*this);
+}
+
+
+
+// =======================================
+//
+//              Causality
+//
+// =======================================
+
+std::uint64_t newCausality()
+{
+#ifdef SOBJECT_THREAD_SAFE
+    static std::atomic<std::uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+#else
+    static std::uint64_t next = 1;
+    return next++;
+#endif
+}
+
+
+
+#ifdef SOBJECT_THREAD_SAFE
+
+// =======================================
+//
+//              EventShard
+//
+// =======================================
+
+namespace _sobject
+{
+
+// Coda MPSC intrusiva (Vyukov): l'inserimento è un solo exchange, senza lock; estrae solo il thread del loop.
+// Il lato dei produttori e quello del consumatore stanno su cache line separate
+class _TaskQueue
+{
+public:
+    _TaskQueue()
+    {
+        m_head.store(&m_stub, std::memory_order_relaxed);
+        m_tail = &m_stub;
+    }
+
+    _TaskQueue(const _TaskQueue&) = delete;
+
+    void push(_Task* task)
+    {
+        task->m_next.store(nullptr, std::memory_order_relaxed);
+        _Task* previous = m_head.exchange(task, std::memory_order_acq_rel);
+        previous->m_next.store(task, std::memory_order_release);
+    }
+
+    // Restituisce nullptr se la coda è vuota o se un produttore non ha ancora collegato il proprio nodo
+    _Task* pop()
+    {
+        _Task* tail = m_tail;
+        _Task* next = tail->m_next.load(std::memory_order_acquire);
+
+        if(tail == &m_stub)
+        {
+            if(next == nullptr) return nullptr;
+            m_tail = next;
+            tail   = next;
+            next   = next->m_next.load(std::memory_order_acquire);
+        }
+
+        if(next != nullptr)
+        {
+            m_tail = next;
+            return tail;
+        }
+
+        if(tail != m_head.load(std::memory_order_acquire)) return nullptr;
+
+        // Ultimo nodo della coda: reinserisco lo stub per poterlo staccare
+        push(&m_stub);
+        next = tail->m_next.load(std::memory_order_acquire);
+        if(next == nullptr) return nullptr;
+
+        m_tail = next;
+        return tail;
+    }
+
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail and m_tail->m_next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // Elimino i task rimasti senza eseguirli
+    void clear()
+    {
+        while(_Task* task = pop()) task->dispose();
+    }
+
+private:
+    // Produttori
+    std::atomic<_Task*> m_head{nullptr};
+    char m_producerPadding[64];
+
+    // Consumatore
+    _Task* m_tail = nullptr;
+    _Task m_stub;
+    char m_consumerPadding[64];
+};
+
+// Traffico campionato in uno shard: oggetti assegnati (con il loro stato, letto dalle migrazioni)
+// e chiamate accodate per coppia (emitter, receiver)
+struct _TrafficSample
+{
+    struct Edge
+    {
+        SObject* emitter;
+        SObject* receiver;
+        std::uint64_t calls;
+    };
+
+    std::vector<std::pair<SObject*, std::shared_ptr<_LoopState>>> objects;
+    std::vector<Edge> edges;
+};
+
+// Event loop di uno shard: una coda per le slot accodate e una per quelle idle, eseguite solo
+// quando la prima è vuota. I contatori, scritti da thread diversi, stanno su cache line separate
+// (padding esplicito, l'allocazione allineata richiede il C++17)
+class _EventShard
+{
+public:
+    _EventShard() {};
+    _EventShard(const _EventShard&) = delete;
+
+    // Accodo un task (da qualsiasi thread) e sveglio il loop se dorme
+    void push(_Task* task, bool idle)
+    {
+        if(idle)
+        {
+            m_idleQueue.push(task);
+        }
+        else
+        {
+            m_queue.push(task);
+            m_posted.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // La fence ordina l'inserimento rispetto alla lettura del flag
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_sleeping.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_wakeup.notify_one();
+        }
+    }
+
+    void start(std::size_t cpu, bool pin)
+    {
+        m_thread = std::thread([this] { run(); });
+
+#ifdef __linux__
+        if(pin)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(m_thread.native_handle(), sizeof(set), &set);
+        }
+#else
+        (void)cpu;
+        (void)pin;
+#endif
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped.store(true, std::memory_order_relaxed);
+        }
+
+        m_wakeup.notify_one();
+        m_thread.join();
+    }
+
+    // Dopo la chiusura di tutti i loop del pool: scarto i task accodati (anche quelli inoltrati da
+    // un altro shard dopo la chiusura di questo) e rilascio gli oggetti ancora assegnati
+    void close()
+    {
+        m_queue.clear();
+        m_idleQueue.clear();
+
+        std::lock_guard<std::mutex> lock(m_objectsMutex);
+        for(SObject* object : m_objects) releaseObject(object);
+        m_objects.clear();
+    }
+
+    bool isCurrent() const;
+
+    void setIdleBudget(std::chrono::nanoseconds budget)
+    {
+        m_idleBudget.store(budget.count(), std::memory_order_relaxed);
+    }
+
+    std::uint64_t posted() const
+    {
+        return m_posted.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t executed() const
+    {
+        return m_executed.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t idleExecuted() const
+    {
+        return m_idleExecuted.load(std::memory_order_relaxed);
+    }
+
+    // Registro degli oggetti assegnati allo shard, letto dal ripartizionamento
+    void registerObject(SObject* object, bool registered)
+    {
+        std::lock_guard<std::mutex> lock(m_objectsMutex);
+        if(registered) m_objects.insert(object);
+        else m_objects.erase(object);
+    }
+
+    // Campiono il traffico delle connect accodate emesse dagli oggetti dello shard. Va chiamata nel
+    // thread del loop, dove gli oggetti assegnati non possono essere distrutti
+    void collect(_TrafficSample& sample);
+
+    // Sposto l'oggetto nello shard target, dal thread del suo shard corrente (o senza shard)
+    static void moveObject(SObject* object, _EventShard* target);
+
+private:
+    // Tolgo lo shard all'oggetto e al suo stato (i task accodati non vengono più inoltrati)
+    static void releaseObject(SObject* object);
+
+private:
+    void run();
+
+    bool empty() const
+    {
+        return m_queue.empty() and m_idleQueue.empty();
+    }
+
+    // Eseguo i task accodati, restituisce il numero di task eseguiti
+    std::size_t drain()
+    {
+        std::size_t count = 0;
+        while(_Task* task = m_queue.pop())
+        {
+            if(task->run()) task->dispose();
+            ++count;
+        }
+
+        if(count != 0) m_executed.store(m_executed.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        return count;
+    }
+
+    // Eseguo i task idle finché la coda principale resta vuota, entro il budget dell'iterazione
+    std::size_t drainIdle()
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(m_idleBudget.load(std::memory_order_relaxed));
+
+        std::size_t count = 0;
+        while(m_queue.empty())
+        {
+            _Task* task = m_idleQueue.pop();
+            if(task == nullptr) break;
+
+            if(task->run()) task->dispose();
+            ++count;
+
+            if(std::chrono::steady_clock::now() >= deadline) break;
+        }
+
+        if(count != 0) m_idleExecuted.store(m_idleExecuted.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        return count;
+    }
+
+    _TaskQueue m_queue;
+    _TaskQueue m_idleQueue;
+
+    std::atomic<std::uint64_t> m_posted{0};
+    char m_postedPadding[64];
+    std::atomic<std::uint64_t> m_executed{0};
+    std::atomic<std::uint64_t> m_idleExecuted{0};
+    char m_executedPadding[64];
+
+    // Tempo massimo dedicato ai task idle in ogni iterazione del loop
+    std::atomic<std::int64_t> m_idleBudget{std::chrono::nanoseconds(std::chrono::milliseconds(1)).count()};
+
+    // Attesa quando le code sono vuote
+    std::atomic<bool> m_sleeping{false};
+    std::atomic<bool> m_stopped{false};
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::thread m_thread;
+
+    std::mutex m_objectsMutex;
+    std::unordered_set<SObject*> m_objects;
+};
+
+namespace
+{
+// Shard del loop in esecuzione sul thread corrente
+thread_local const _EventShard* currentShard = nullptr;
+
+// Iterazioni a vuoto prima di addormentare il loop
+const unsigned idleSpins = 256;
+}
+
+bool _EventShard::isCurrent() const
+{
+    return currentShard == this;
+}
+
+void _EventShard::run()
+{
+    currentShard = this;
+
+    for(;;)
+    {
+        // I task idle partono solo quando non ci sono task accodati
+        if(drain() != 0) continue;
+        if(drainIdle() != 0) continue;
+        if(m_stopped.load(std::memory_order_relaxed) and empty()) break;
+
+        unsigned spins = 0;
+        while(empty() and spins < idleSpins)
+        {
+            std::this_thread::yield();
+            ++spins;
+        }
+        if(not empty()) continue;
+
+        // Mi addormento: il flag viene scritto prima di ricontrollare le code, come letto dai produttori
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeup.wait(lock, [this] { return not empty() or m_stopped.load(std::memory_order_relaxed); });
+        }
+
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    currentShard = nullptr;
+}
+
+_EventShard* _queuedShard(const SObject* receiver, bool idle)
+{
+    // Le slot idle passano sempre dalla coda, anche dal thread dello shard
+    _EventShard* shard = receiver->m_shard.load(std::memory_order_acquire);
+    if(shard == nullptr or (not idle and shard->isCurrent())) return nullptr;
+
+    return shard;
+}
+
+std::shared_ptr<const _LoopState> _loopState(const SObject* receiver)
+{
+    // Letto dagli emit di qualsiasi thread mentre il pool può crearlo
+    return std::atomic_load(&receiver->m_loopState);
+}
+
+void _postTask(_EventShard* shard, _Task* task, bool idle)
+{
+    shard->push(task, idle);
+}
+
+bool _forwardTask(const _LoopState& state, _Task* task, bool idle)
+{
+    // Oggetto rilasciato dal pool: il task resta nello shard in cui era stato accodato
+    _EventShard* shard = state.shard.load(std::memory_order_acquire);
+    if(shard == nullptr or shard->isCurrent()) return false;
+
+    shard->push(task, idle);
+    return true;
+}
+
+void _registerObject(_EventShard* shard, SObject* object, bool registered)
+{
+    shard->registerObject(object, registered);
+}
+
+void _EventShard::collect(_TrafficSample& sample)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_objectsMutex);
+        for(SObject* object : m_objects) sample.objects.emplace_back(object, std::atomic_load(&object->m_loopState));
+    }
+
+    for(const auto& entry : sample.objects)
+    {
+        SObject* object = entry.first;
+        _StripeReadLock readLock(object);
+
+        for(const _SignalBase* signal : object->m_signalsList)
+        {
+            for(_SlotCore* slot : signal->slots())
+            {
+                if(not slot->isDeferred()) continue;
+
+                const std::uint64_t calls = slot->takeTraffic();
+                if(calls != 0) sample.edges.push_back(_TrafficSample::Edge{object, slot->getReceiver(), calls});
+            }
+        }
+    }
+}
+
+void _EventShard::releaseObject(SObject* object)
+{
+    object->m_shard.store(nullptr, std::memory_order_release);
+    if(std::shared_ptr<_LoopState> state = std::atomic_load(&object->m_loopState)) state->shard.store(nullptr, std::memory_order_release);
+}
+
+void _EventShard::moveObject(SObject* object, _EventShard* target)
+{
+    _EventShard* current = object->m_shard.load(std::memory_order_acquire);
+    if(current == target) return;
+
+    if(current != nullptr) current->registerObject(object, false);
+    target->registerObject(object, true);
+
+    // I task accodati nel vecchio shard leggono il nuovo dallo stato condiviso e vengono inoltrati
+    std::atomic_load(&object->m_loopState)->shard.store(target, std::memory_order_release);
+    object->m_shard.store(target, std::memory_order_release);
+}
+
+namespace
+{
+// Funzione eseguita nel loop di uno shard (campionamento del traffico)
+class FunctionTask : public _Task
+{
+public:
+    explicit FunctionTask(std::function<void()> function) : m_function(std::move(function)) {};
+
+    virtual bool run() override
+    {
+        m_function();
+        return true;
+    }
+
+private:
+    std::function<void()> m_function;
+};
+
+// Migrazione di un oggetto, eseguita nel loop del suo shard tra due task
+class MigrateTask : public _Task
+{
+public:
+    MigrateTask(SObject* object, std::shared_ptr<_LoopState> state, _EventShard* target)
+        : m_object(object), m_state(std::move(state)), m_target(target) {};
+
+    virtual bool run() override
+    {
+        if(not m_state->alive.load(std::memory_order_acquire)) return true;
+
+        // Oggetto già spostato da un'altra migrazione: seguo l'oggetto
+        if(_forwardTask(*m_state, this, false)) return false;
+
+        _EventShard::moveObject(m_object, m_target);
+        return true;
+    }
+
+private:
+    SObject* const m_object;
+    const std::shared_ptr<_LoopState> m_state;
+    _EventShard* const m_target;
+};
+}
+
+// Thread del ripartizionamento periodico ed esito dell'ultimo ripartizionamento
+class _Balancer
+{
+public:
+    // Ciclo del thread: un rebalance() ogni intervallo, finché il pool non viene distrutto
+    void run(SEventLoopPool* pool)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while(not m_stopped)
+        {
+            if(m_interval.count() == 0)
+            {
+                m_wakeup.wait(lock);
+                continue;
+            }
+
+            if(m_wakeup.wait_for(lock, m_interval, [this] { return m_stopped; })) break;
+
+            lock.unlock();
+            pool->rebalance();
+            lock.lock();
+        }
+    }
+
+    void setInterval(SEventLoopPool* pool, std::chrono::milliseconds interval)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_interval = interval;
+            if(not m_thread.joinable() and interval.count() != 0) m_thread = std::thread([this, pool] { run(pool); });
+        }
+
+        m_wakeup.notify_one();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+
+        m_wakeup.notify_one();
+        if(m_thread.joinable()) m_thread.join();
+    }
+
+    // Un solo ripartizionamento alla volta (periodico o esplicito)
+    std::mutex m_rebalanceMutex;
+
+    mutable std::mutex m_reportMutex;
+    SPlacementReport m_report;
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::chrono::milliseconds m_interval{0};
+    bool m_stopped = false;
+    std::thread m_thread;
+};
+
+} // namespace _sobject
+
+
+
+// =======================================
+//
+//            EventLoopPool
+//
+// =======================================
+
+SEventLoopPool::SEventLoopPool(std::size_t shards, bool pinThreads)
+{
+    const std::size_t cores = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    if(shards == 0) shards = cores;
+
+    m_shards.reserve(shards);
+    for(std::size_t i = 0; i < shards; ++i)
+    {
+        m_shards.push_back(new _sobject::_EventShard);
+        m_shards.back()->start(i % cores, pinThreads);
+    }
+
+    m_balancer = new _sobject::_Balancer;
+}
+
+SEventLoopPool::~SEventLoopPool()
+{
+    stop();
+
+    delete m_balancer;
+    for(_sobject::_EventShard* shard : m_shards) delete shard;
+}
+
+void SEventLoopPool::stop()
+{
+    // Dal loop di uno shard aspetterei la chiusura del thread stesso
+    for(const _sobject::_EventShard* shard : m_shards)
+    {
+        if(shard->isCurrent()) return;
+    }
+
+    if(m_stopped.exchange(true)) return;
+
+    // Il ripartizionamento periodico accoda task negli shard: lo fermo per primo
+    m_balancer->stop();
+
+    // Ogni loop esegue i task rimasti prima di chiudersi, poi scarto quelli inoltrati ai loop già chiusi
+    for(_sobject::_EventShard* shard : m_shards) shard->stop();
+    for(_sobject::_EventShard* shard : m_shards) shard->close();
+}
+
+std::size_t SEventLoopPool::assign(SObject* object)
+{
+    // Stesso hash di Fibonacci degli stripe, ridotto al numero di shard
+    const std::uint64_t address = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(object) >> 4);
+    const std::size_t shard = static_cast<std::size_t>(((address * 0x9E3779B97F4A7C15ull) >> 32) % m_shards.size());
+
+    assign(object, shard);
+    return shard;
+}
+
+void SEventLoopPool::assign(SObject* object, std::size_t shard)
+{
+    if(m_stopped.load()) return;
+
+    _sobject::_EventShard* target = m_shards.at(shard);
+
+    // Lo stato viene creato alla prima assegnazione e resta fino alla distruzione dell'oggetto.
+    // Gli emit verso l'oggetto lo leggono senza lock: viene pubblicato in modo atomico
+    std::shared_ptr<_sobject::_LoopState> state = std::atomic_load(&object->m_loopState);
+    if(not state)
+    {
+        std::shared_ptr<_sobject::_LoopState> created = std::make_shared<_sobject::_LoopState>();
+        if(std::atomic_compare_exchange_strong(&object->m_loopState, &state, created)) state = created;
+    }
+
+    _sobject::_EventShard* current = object->m_shard.load(std::memory_order_acquire);
+    if(current != nullptr) current->registerObject(object, false);
+    target->registerObject(object, true);
+
+    state->shard.store(target, std::memory_order_release);
+    object->m_shard.store(target, std::memory_order_release);
+}
+
+void SEventLoopPool::release(SObject* object)
+{
+    _sobject::_EventShard* current = object->m_shard.exchange(nullptr, std::memory_order_acq_rel);
+    if(current != nullptr) current->registerObject(object, false);
+
+    if(std::shared_ptr<_sobject::_LoopState> state = std::atomic_load(&object->m_loopState)) state->shard.store(nullptr, std::memory_order_release);
+}
+
+void SEventLoopPool::migrate(SObject* object, std::size_t shard)
+{
+    if(m_stopped.load()) return;
+
+    _sobject::_EventShard* target  = m_shards.at(shard);
+    _sobject::_EventShard* current = object->m_shard.load(std::memory_order_acquire);
+
+    // Oggetto senza shard o migrazione dal suo stesso loop: il cambio avviene subito
+    if(current == nullptr)
+    {
+        assign(object, shard);
+        return;
+    }
+
+    if(current->isCurrent())
+    {
+        _sobject::_EventShard::moveObject(object, target);
+        return;
+    }
+
+    current->push(new _sobject::MigrateTask(object, std::atomic_load(&object->m_loopState), target), false);
+}
+
+SPlacementReport SEventLoopPool::rebalance(double imbalance)
+{
+    // Dal loop di uno shard il campionamento aspetterebbe un task accodato nello shard stesso:
+    // non ripartiziono e restituisco un esito vuoto
+    for(const _sobject::_EventShard* shard : m_shards)
+    {
+        if(shard->isCurrent()) return SPlacementReport();
+    }
+
+    // Pool chiuso: nessun loop eseguirebbe il campionamento
+    if(m_stopped.load()) return SPlacementReport();
+
+    std::lock_guard<std::mutex> rebalanceLock(m_balancer->m_rebalanceMutex);
+
+    // Campionamento nel loop di ogni shard, dove i suoi oggetti non possono essere distrutti
+    std::vector<_sobject::_TrafficSample> samples(m_shards.size());
+    {
+        std::mutex mutex;
+        std::condition_variable done;
+        std::size_t pending = m_shards.size();
+
+        for(std::size_t i = 0; i < m_shards.size(); ++i)
+        {
+            _sobject::_EventShard* shard     = m_shards[i];
+            _sobject::_TrafficSample* sample = &samples[i];
+            m_shards[i]->push(new _sobject::FunctionTask([shard, sample, &mutex, &done, &pending]
+            {
+                shard->collect(*sample);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if(--pending == 0) done.notify_one();
+            }), false);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&pending] { return pending == 0; });
+    }
+
+    // Grafo degli oggetti: indice, shard di partenza e traffico verso gli altri oggetti del pool
+    std::unordered_map<SObject*, std::size_t> index;
+    std::vector<const std::pair<SObject*, std::shared_ptr<_sobject::_LoopState>>*> nodes;
+    std::vector<std::size_t> origin;
+
+    for(std::size_t shard = 0; shard < samples.size(); ++shard)
+    {
+        for(const auto& entry : samples[shard].objects)
+        {
+            if(not index.emplace(entry.first, nodes.size()).second) continue;
+            nodes.push_back(&entry);
+            origin.push_back(shard);
+        }
+    }
+
+    std::vector<std::size_t> placement = origin;
+
+    const std::size_t count = nodes.size();
+    std::vector<std::vector<std::pair<std::size_t, std::uint64_t>>> neighbours(count);
+    std::vector<std::uint64_t> weight(count, 0);
+    std::vector<std::pair<std::size_t, std::size_t>> edges;
+    std::vector<std::uint64_t> edgeCalls;
+
+    SPlacementReport report;
+    for(const _sobject::_TrafficSample& sample : samples)
+    {
+        for(const _sobject::_TrafficSample::Edge& edge : sample.edges)
+        {
+            const auto emitter  = index.find(edge.emitter);
+            const auto receiver = index.find(edge.receiver);
+            if(emitter == index.end() or receiver == index.end() or emitter->second == receiver->second) continue;
+
+            neighbours[emitter->second].emplace_back(receiver->second, edge.calls);
+            neighbours[receiver->second].emplace_back(emitter->second, edge.calls);
+            weight[emitter->second]  += edge.calls;
+            weight[receiver->second] += edge.calls;
+            edges.emplace_back(emitter->second, receiver->second);
+            edgeCalls.push_back(edge.calls);
+            report.traffic += edge.calls;
+        }
+    }
+
+    const auto crossTraffic = [&]
+    {
+        std::uint64_t cross = 0;
+        for(std::size_t i = 0; i < edges.size(); ++i)
+        {
+            if(placement[edges[i].first] != placement[edges[i].second]) cross += edgeCalls[i];
+        }
+        return cross;
+    };
+    report.crossTrafficBefore = crossTraffic();
+
+    // Ripartizionamento greedy: ogni oggetto (dal più trafficato) passa allo shard con cui scambia più
+    // chiamate se ha ancora posto, altrimenti si scambia con l'oggetto di quello shard che rende di più.
+    // Ogni passo riduce il traffico tra shard, mi fermo quando non ce ne sono
+    const std::size_t shards   = m_shards.size();
+    const std::size_t capacity = std::max<std::size_t>(1, static_cast<std::size_t>((double(count) / double(shards)) * (1.0 + imbalance) + 0.999));
+
+    std::vector<std::size_t> load(shards, 0);
+    for(std::size_t shard : placement) ++load[shard];
+
+    std::vector<std::size_t> order(count);
+    for(std::size_t i = 0; i < count; ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&weight](std::size_t a, std::size_t b) { return weight[a] > weight[b]; });
+
+    // Chiamate tra l'oggetto e quelli di uno shard, e tra due oggetti
+    const auto trafficTo = [&](std::size_t node, std::size_t shard)
+    {
+        std::int64_t calls = 0;
+        for(const auto& neighbour : neighbours[node])
+        {
+            if(placement[neighbour.first] == shard) calls += std::int64_t(neighbour.second);
+        }
+        return calls;
+    };
+    const auto trafficBetween = [&](std::size_t node, std::size_t other)
+    {
+        std::int64_t calls = 0;
+        for(const auto& neighbour : neighbours[node])
+        {
+            if(neighbour.first == other) calls += std::int64_t(neighbour.second);
+        }
+        return calls;
+    };
+
+    for(int pass = 0; pass < 8; ++pass)
+    {
+        bool moved = false;
+        for(std::size_t node : order)
+        {
+            if(weight[node] == 0) break;
+
+            const std::size_t current = placement[node];
+            const std::int64_t here   = trafficTo(node, current);
+
+            std::int64_t bestGain = 0;
+            std::size_t bestShard = current;
+            std::size_t partner   = count;
+
+            for(std::size_t shard = 0; shard < shards; ++shard)
+            {
+                const std::int64_t gain = shard != current ? trafficTo(node, shard) - here : 0;
+                if(gain <= bestGain) continue;
+
+                if(load[shard] < capacity)
+                {
+                    bestGain  = gain;
+                    bestShard = shard;
+                    partner   = count;
+                    continue;
+                }
+
+                // Shard pieno: cerco l'oggetto con cui lo scambio riduce di più il traffico tra shard
+                for(std::size_t other = 0; other < count; ++other)
+                {
+                    if(placement[other] != shard) continue;
+
+                    const std::int64_t swapGain = gain + trafficTo(other, current) - trafficTo(other, shard) - 2 * trafficBetween(node, other);
+                    if(swapGain <= bestGain) continue;
+
+                    bestGain  = swapGain;
+                    bestShard = shard;
+                    partner   = other;
+                }
+            }
+
+            if(bestShard == current) continue;
+
+            if(partner != count)
+            {
+                placement[partner] = current;
+            }
+            else
+            {
+                --load[current];
+                ++load[bestShard];
+            }
+
+            placement[node] = bestShard;
+            moved = true;
+        }
+
+        if(not moved) break;
+    }
+
+    report.crossTrafficAfter = crossTraffic();
+    report.objects           = load;
+
+    // Migrazioni, accodate nel loop dello shard da cui è stato campionato ogni oggetto
+    for(std::size_t node = 0; node < count; ++node)
+    {
+        const std::size_t from = origin[node];
+        const std::size_t to   = placement[node];
+        if(to == from) continue;
+
+        m_shards[from]->push(new _sobject::MigrateTask(nodes[node]->first, nodes[node]->second, m_shards[to]), false);
+        report.moves.push_back(SPlacementMove{nodes[node]->first, from, to});
+    }
+
+    std::lock_guard<std::mutex> reportLock(m_balancer->m_reportMutex);
+    m_balancer->m_report = report;
+    return report;
+}
+
+void SEventLoopPool::setRebalanceInterval(std::chrono::milliseconds interval)
+{
+    m_balancer->setInterval(this, interval);
+}
+
+SPlacementReport SEventLoopPool::placementReport() const
+{
+    std::lock_guard<std::mutex> lock(m_balancer->m_reportMutex);
+    return m_balancer->m_report;
+}
+
+std::size_t SEventLoopPool::shardOf(const SObject* object) const
+{
+    const _sobject::_EventShard* shard = object->m_shard.load(std::memory_order_acquire);
+    return std::find(m_shards.begin(), m_shards.end(), shard) - m_shards.begin();
+}
+
+std::uint64_t SEventLoopPool::postedCount(std::size_t shard) const
+{
+    return m_shards.at(shard)->posted();
+}
+
+std::uint64_t SEventLoopPool::executedCount(std::size_t shard) const
+{
+    return m_shards.at(shard)->executed();
+}
+
+std::uint64_t SEventLoopPool::idleExecutedCount(std::size_t shard) const
+{
+    return m_shards.at(shard)->idleExecuted();
+}
+
+void SEventLoopPool::setIdleBudget(std::chrono::nanoseconds budget)
+{
+    for(_sobject::_EventShard* shard : m_shards) shard->setIdleBudget(budget);
+}
+
+#endif // SOBJECT_THREAD_SAFE
+
+
+
+#ifdef SOBJECT_THREAD_SAFE
+
+// =======================================
+//
+//              Scheduler
+//
+// =======================================
+
+namespace _sobject
+{
+
+// Grafo delle slot accodate in SSlotScheduler: ogni slot è un job, che dipende dall'ultimo job
+// precedente che scrive una delle sue risorse e, se ne scrive, dai job che le hanno lette dopo di lui.
+// I job senza dipendenze in attesa stanno nella coda dei pronti, condivisa tra i thread
+class _Scheduler
+{
+public:
+    explicit _Scheduler(std::size_t threads)
+    {
+        for(std::size_t i = 0; i < threads; ++i) m_threads.emplace_back([this] { work(); });
+    }
+
+    ~_Scheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+
+        m_wakeup.notify_all();
+        for(std::thread& thread : m_threads) thread.join();
+
+        // Emit accodati e mai eseguiti
+        clear();
+    }
+
+    std::size_t size() const
+    {
+        return m_threads.size();
+    }
+
+    // Salvo le slot connesse ora al segnale, con il lock condiviso dell'emitter
+    void post(SObject* emitter, const _MethodKey& key, _ScheduledEmit* emit)
+    {
+        m_posts.push_back(Post{emitter, key, emit, nullptr, 0, _causality()});
+        Post& post = m_posts.back();
+
+        _StripeReadLock readLock(emitter);
+
+        post.signal = emitter->findSignal(key);
+        if(post.signal == nullptr) return;
+
+        post.version = post.signal->m_version;
+        emit->record(post.signal);
+
+        for(_SlotCore* slot : post.signal->slots())
+        {
+            Job job;
+            job.post      = m_posts.size() - 1;
+            job.slot      = slot;
+            job.exclusive = slot->isSingleShot();
+
+            // Una slot single shot viene staccata dal segnale: la eseguo da sola
+            job.reads  = job.exclusive ? ~std::uint64_t(0) : slot->reads();
+            job.writes = job.exclusive ? ~std::uint64_t(0) : slot->writes();
+            m_jobs.push_back(std::move(job));
+        }
+    }
+
+    void run()
+    {
+        if(not m_jobs.empty())
+        {
+            build();
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_completed = 0;
+            for(std::size_t index = 0; index < m_jobs.size(); ++index)
+            {
+                if(m_jobs[index].waiting == 0) m_ready.push_back(index);
+            }
+            m_wakeup.notify_all();
+
+            // Anche il thread chiamante esegue i job, finché non sono terminati tutti
+            for(;;)
+            {
+                m_wakeup.wait(lock, [this] { return not m_ready.empty() or m_completed == m_jobs.size(); });
+                if(m_completed == m_jobs.size()) break;
+
+                step(lock);
+            }
+        }
+
+        clear();
+    }
+
+private:
+    struct Post
+    {
+        SObject* emitter;
+        _MethodKey key;
+        _ScheduledEmit* emit;
+
+        // Segnale e versione delle sue slot al momento di post()
+        _SignalBase* signal;
+        std::size_t version;
+
+        // Causalità del thread che ha accodato l'emit, ripristinata nei thread dello scheduler
+        std::uint64_t causality;
+    };
+
+    struct Job
+    {
+        std::size_t post;
+        _SlotCore* slot;
+        std::uint64_t reads;
+        std::uint64_t writes;
+        bool exclusive;
+
+        // Dipendenze non ancora eseguite e job che dipendono da questo
+        std::size_t waiting = 0;
+        std::vector<std::size_t> successors;
+    };
+
+    // Dipendenze tra i job nell'ordine degli emit e delle slot
+    void build()
+    {
+        const std::size_t none = std::size_t(-1);
+
+        // Per ogni risorsa: ultimo job che la scrive e job che la leggono dopo di lui
+        std::size_t writer[_StripeCount];
+        std::vector<std::size_t> readers[_StripeCount];
+        std::fill(writer, writer + _StripeCount, none);
+
+        // Ultimo job a cui ho aggiunto ogni predecessore, per non duplicare gli archi
+        std::vector<std::size_t> linked(m_jobs.size(), none);
+
+        for(std::size_t index = 0; index < m_jobs.size(); ++index)
+        {
+            Job& job = m_jobs[index];
+
+            const auto depend = [&](std::size_t previous)
+            {
+                if(linked[previous] == index) return;
+                linked[previous] = index;
+
+                m_jobs[previous].successors.push_back(index);
+                ++job.waiting;
+            };
+
+            for(std::size_t bit = 0; bit < _StripeCount; ++bit)
+            {
+                const bool reads  = (job.reads >> bit) & 1;
+                const bool writes = (job.writes >> bit) & 1;
+                if(not reads and not writes) continue;
+
+                if(writer[bit] != none) depend(writer[bit]);
+
+                if(writes)
+                {
+                    for(std::size_t reader : readers[bit]) depend(reader);
+                    readers[bit].clear();
+                    writer[bit] = index;
+                }
+                else
+                {
+                    readers[bit].push_back(index);
+                }
+            }
+        }
+    }
+
+    // Thread dello scheduler: eseguo i job pronti finché lo scheduler non viene distrutto
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        for(;;)
+        {
+            m_wakeup.wait(lock, [this] { return m_stopped or not m_ready.empty(); });
+            if(m_stopped) return;
+
+            step(lock);
+        }
+    }
+
+    // Eseguo il primo job pronto senza tenere m_mutex, poi sblocco quelli che dipendono da lui
+    void step(std::unique_lock<std::mutex>& lock)
+    {
+        const std::size_t index = m_ready.front();
+        m_ready.pop_front();
+
+        lock.unlock();
+        execute(m_jobs[index]);
+        lock.lock();
+
+        std::size_t released = 0;
+        for(std::size_t next : m_jobs[index].successors)
+        {
+            if(--m_jobs[next].waiting != 0) continue;
+
+            m_ready.push_back(next);
+            ++released;
+        }
+
+        // All'ultimo job sveglio anche il thread che attende in run()
+        if(++m_completed == m_jobs.size() or released > 1) m_wakeup.notify_all();
+        else if(released == 1) m_wakeup.notify_one();
+    }
+
+    void execute(const Job& job)
+    {
+        const Post& post = m_posts[job.post];
+        if(post.signal == nullptr) return;
+
+        const std::uint64_t previous = _causality();
+        _causality() = post.causality;
+
+        if(job.exclusive)
+        {
+            // Come nell'emit la slot single shot viene staccata prima dell'esecuzione
+            _StripeWriteLock writeLock(_stripeMask(post.emitter));
+            if(connected(post, job.slot))
+            {
+                // Il segnale resta valido anche se la slot lo modifica (i lock vengono sospesi)
+                _IterationScope scope(post.signal);
+                post.signal->detachAt(job.slot->position());
+                post.emit->call(job.slot);
+                post.signal->destroySlot(job.slot);
+            }
+        }
+        else
+        {
+            _StripeReadLock readLock(post.emitter);
+            if(connected(post, job.slot))
+            {
+                _IterationScope scope(post.signal);
+                post.emit->call(job.slot);
+            }
+        }
+
+        _causality() = previous;
+    }
+
+    // La slot è ancora connessa al segnale (se le slot sono cambiate dopo post() la cerco nella lista)
+    static bool connected(const Post& post, const _SlotCore* slot)
+    {
+        if(post.emitter->findSignal(post.key) != post.signal) return false;
+        if(post.signal->m_version == post.version) return true;
+
+        const _SignalBase::SlotList& slots = post.signal->slots();
+        return std::find(slots.begin(), slots.end(), slot) != slots.end();
+    }
+
+    void clear()
+    {
+        for(const Post& post : m_posts) delete post.emit;
+
+        m_posts.clear();
+        m_jobs.clear();
+    }
+
+    std::vector<Post> m_posts;
+    std::vector<Job> m_jobs;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::deque<std::size_t> m_ready;
+    std::size_t m_completed = 0;
+    bool m_stopped = false;
+
+    std::vector<std::thread> m_threads;
+};
+
+} // namespace _sobject
+
+
+
+// =======================================
+//
+//             SlotScheduler
+//
+// =======================================
+
+SSlotScheduler::SSlotScheduler(std::size_t threads)
+{
+    if(threads == 0) threads = std::max<unsigned>(1, std::thread::hardware_concurrency()) - 1;
+    m_scheduler = new _sobject::_Scheduler(threads);
+}
+
+SSlotScheduler::~SSlotScheduler()
+{
+    delete m_scheduler;
+}
+
+void SSlotScheduler::post(SObject* emitter, const _sobject::_MethodKey& key, _sobject::_ScheduledEmit* emit)
+{
+    m_scheduler->post(emitter, key, emit);
+}
+
+void SSlotScheduler::run()
+{
+    m_scheduler->run();
+}
+
+std::size_t SSlotScheduler::size() const
+{
+    return m_scheduler->size();
+}
+
+#endif // SOBJECT_THREAD_SAFE
@@ -1,13 +1,120 @@
 #ifndef SOBJECT_H
 #define SOBJECT_H
 
-#include <list>
 #include <algorithm>
+#include <chrono>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <tuple>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <new>
+#include <type_traits>
+
+// L'emit con seqlock richiede la modalità thread safe
+#if defined(SOBJECT_SEQLOCK_EMIT) and not defined(SOBJECT_THREAD_SAFE)
+#define SOBJECT_THREAD_SAFE
+#endif
+
+#ifdef SOBJECT_THREAD_SAFE
+#include <atomic>
+#include <memory>
+#endif
+
+#ifdef __cpp_impl_coroutine
+#include <coroutine>
+#endif
+
+#if __cplusplus >= 202002L
+#include <version>
+#endif
+
+#ifdef __cpp_lib_senders
+#include <execution>
+#endif
 
 #define S_SIGNAL
 #define S_SLOT
 
 class SObject;
+class SModuleToken;
+
+
+
+// =======================================
+//
+//            SConnectionType
+//
+// =======================================
+
+// Opzioni della connect (combinabili tramite l'operatore |)
+enum SConnectionType : unsigned
+{
+    SDefaultConnection    = 0x0000,
+    SReplayLastConnection = 0x0001,     // Alla connect la slot riceve l'ultimo valore emesso
+    SReplayAllConnection  = 0x0002,     // Alla connect la slot riceve tutto il buffer di replay
+    SSingleShotConnection = 0x0004,     // La slot viene eseguita una sola volta e poi disconnessa
+    SUniqueConnection     = 0x0008,     // La connect viene rifiutata se la stessa slot è già connessa
+    SPreConnection        = 0x0010,     // La slot viene eseguita prima di quelle senza gruppo
+    SPostConnection       = 0x0020,     // La slot viene eseguita dopo quelle senza gruppo
+    SQueuedConnection     = 0x0040,     // La slot viene eseguita nell'event loop del receiver (SEventLoopPool)
+    SIdleConnection       = 0x0080      // La slot viene eseguita dall'event loop del receiver quando non ha altro lavoro
+};
+
+inline SConnectionType operator|(SConnectionType a, SConnectionType b)
+{
+    return static_cast<SConnectionType>(static_cast<unsigned>(a) | static_cast<unsigned>(b));
+}
+
+// Limite di chiamate di una connect (token bucket): in media al più perSecond chiamate al secondo,
+// con raffiche fino a burst chiamate. Le chiamate oltre il limite vengono scartate e contate.
+// Servono perSecond > 0 e burst >= 1, altrimenti la connect non viene effettuata (restituisce false)
+struct SRateLimit
+{
+    double perSecond;
+    double burst;
+};
+
+// Campionamento di una connect: la slot riceve un emit ogni every, oppure con random
+// un emit scelto a caso, in media uno ogni every
+struct SSampling
+{
+    std::uint32_t every;
+    bool random;
+};
+
+#ifdef SOBJECT_THREAD_SAFE
+// Risorse lette e scritte da una slot, usate da SSlotScheduler per eseguire in parallelo le slot che
+// non sono in conflitto. Ogni risorsa (un indirizzo) diventa uno di 64 bit: due risorse con lo stesso
+// bit vengono trattate come una sola, l'unico effetto è una serializzazione in più
+struct SAccess
+{
+    std::uint64_t reads  = 0;
+    std::uint64_t writes = 0;
+
+    SAccess& read(const void* resource)
+    {
+        reads |= bit(resource);
+        return *this;
+    }
+
+    SAccess& write(const void* resource)
+    {
+        writes |= bit(resource);
+        return *this;
+    }
+
+    static std::uint64_t bit(const void* resource);
+};
+#endif
+
+
 
 /* ===========================================================================
  *
@@ -15,6 +122,10 @@ class SObject;
  *    le strutture alle quali l'utente non deve avere accesso.
  *    Per le classi e i metodi da utilizzare saltare il namespace.
  *
+ *    Tutta la gestione delle connect è implementata una sola volta nelle
+ *    classi non template (_MethodKey, _SlotCore, _SignalBase) compilate in
+ *    sobject.cpp; le classi template aggiungono solo la chiamata tipizzata.
+ *
  * ===========================================================================
  */
 
@@ -23,435 +134,3968 @@ namespace _sobject
 
 // =======================================
 //
-//              SlotBase
+//            IndexSequence
 //
 // =======================================
 
-template <typename... Args>
-class _SlotBase
+// Sequenza di indici per espandere le tuple (std::index_sequence è disponibile solo dal C++14)
+template <std::size_t... I>
+struct _IndexSequence {};
+
+template <std::size_t N, std::size_t... I>
+struct _MakeIndexSequence : _MakeIndexSequence<N - 1, N - 1, I...> {};
+
+template <std::size_t... I>
+struct _MakeIndexSequence<0, I...>
 {
-protected:
-    // Costruttori protected in modo che solo Slot possa creare oggetti di questo tipo
-    _SlotBase() = default;
-    _SlotBase(const _SlotBase&) = delete;
+    typedef _IndexSequence<I...> type;
+};
+
+
+
+// =======================================
+//
+//             StripeLock
+//
+// =======================================
 
+// Con SOBJECT_THREAD_SAFE ogni SObject usa uno dei _StripeCount lock RW scelti tramite il suo indirizzo:
+// l'emit prende il lock condiviso, connect e disconnect quello esclusivo.
+// Senza SOBJECT_THREAD_SAFE le classi seguenti sono vuote e non generano codice
+enum : std::size_t
+{
+    _StripeCount = 64
+};
+
+inline std::size_t _stripeIndex(const void* object)
+{
+    // Hash di Fibonacci dell'indirizzo, i 6 bit alti scelgono uno dei 64 stripe
+    const std::uint64_t address = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(object) >> 4);
+    return static_cast<std::size_t>((address * 0x9E3779B97F4A7C15ull) >> 58);
+}
+
+inline std::uint64_t _stripeMask(const void* object)
+{
+    return std::uint64_t(1) << _stripeIndex(object);
+}
+
+#ifdef SOBJECT_THREAD_SAFE
+
+// Lock condiviso sullo stripe di un oggetto (se il thread ha già lo stripe in esclusiva non fa nulla)
+class _StripeReadLock
+{
 public:
-    virtual ~_SlotBase() {};
+    explicit _StripeReadLock(const void* object);
+    _StripeReadLock(const _StripeReadLock&) = delete;
+    ~_StripeReadLock();
 
+private:
+    std::size_t m_stripe;
+};
 
+// Lock esclusivo sugli stripe della maschera, acquisiti in ordine di indirizzo.
+// Prima di attendere il thread rilascia i lock che già possiede (es. quello condiviso di un emit
+// in corso, quando la connect avviene da una slot) e li riprende alla fine, così nessun thread
+// attende un lock tenendone altri e non si possono formare deadlock. Gli emit del thread restano
+// validi: i segnali che stanno scorrendo vengono segnati come in uso finché i lock non tornano
+// al thread, e chi li modifica nel frattempo trattiene le slot rimosse invece di eliminarle
+class _StripeWriteLock
+{
+public:
+    explicit _StripeWriteLock(std::uint64_t mask);
+    _StripeWriteLock(const _StripeWriteLock&) = delete;
+    ~_StripeWriteLock();
 
-    // ===============================
-    //
-    //  Metodi astratti
+    bool acquired() const
+    {
+        return m_mask != 0;
+    }
+
+private:
+    std::uint64_t m_mask;
+    unsigned m_suspended[_StripeCount];
+
+    // Scansioni del thread già segnate come in uso prima di questo lock
+    std::size_t m_published = 0;
+};
 
+// Spin lock delle strutture condivise da più emitter (lista del receiver, token dei moduli, replay).
+// Non viene mai tenuto mentre si attende un altro lock
+class _SpinLock
+{
 public:
-    virtual bool compareByPointer(const _SlotBase* other) const = 0;
-    virtual bool compareByReceiver(const SObject* receiver) const = 0;
-    virtual SObject* getReceiver() const = 0;
-    virtual void exec(Args&&...) = 0;
+    void lock()
+    {
+        while(m_flag.test_and_set(std::memory_order_acquire)) {}
+    }
 
+    void unlock()
+    {
+        m_flag.clear(std::memory_order_release);
+    }
 
+private:
+    std::atomic_flag m_flag = ATOMIC_FLAG_INIT;
+};
 
-    // ===============================
-    //
-    //  CustomSlotCompare
+class _SpinGuard
+{
+public:
+    explicit _SpinGuard(_SpinLock& lock) : m_lock(lock)
+    {
+        m_lock.lock();
+    }
+
+    _SpinGuard(const _SpinGuard&) = delete;
+
+    ~_SpinGuard()
+    {
+        m_lock.unlock();
+    }
+
+private:
+    _SpinLock& m_lock;
+};
+
+#else
+
+class _StripeReadLock
+{
+public:
+    explicit _StripeReadLock(const void*) {}
+};
 
+class _StripeWriteLock
+{
 public:
-    struct CustomSlotCompare
+    explicit _StripeWriteLock(std::uint64_t) {}
+
+    bool acquired() const
     {
-        CustomSlotCompare() = delete;
-        CustomSlotCompare(const _SlotBase<Args...>* slot, const bool& deleteObject= true) : m_deleteObject(deleteObject), m_slot(slot){};
-        CustomSlotCompare(const SObject* receiver,        const bool& deleteObject= true) : m_deleteObject(deleteObject), m_receiver(receiver){};
+        return false;
+    }
+};
 
-        bool operator()(const _SlotBase* slot) const
-        {
-            bool result = false;
+#endif // SOBJECT_THREAD_SAFE
 
-            // Controllo se rimuovo per slot o per ricevitore
-            if(m_slot     != nullptr) result = slot->compareByPointer(m_slot);
-            if(m_receiver != nullptr) result = slot->compareByReceiver(m_receiver);
 
-            // Se devo rimuovere la slot dealloco la memoria
-            if(result and m_deleteObject)
-            {
-                delete slot;
-            }
 
-            return result;
-        }
+#ifdef SOBJECT_SEQLOCK_EMIT
 
-        const bool m_deleteObject        = true;
-        const _SlotBase<Args...>* m_slot = nullptr;
-        const SObject* m_receiver        = nullptr;
-    };
+// =======================================
+//
+//                Epoch
+//
+// =======================================
+
+// Con SOBJECT_SEQLOCK_EMIT l'emit legge le connect senza lock. Gli oggetti rimossi dagli scrittori
+// (slot, segnali, snapshot) vengono eliminati solo quando nessun emit iniziato prima è ancora in corso
+
+// Emit in corso sul thread corrente (annidabile): pubblica l'epoca letta, con una store e senza RMW
+class _EpochGuard
+{
+public:
+    _EpochGuard();
+    _EpochGuard(const _EpochGuard&) = delete;
+    ~_EpochGuard();
 };
 
+// Eliminazione differita di un oggetto non più raggiungibile dagli emit
+void _retire(void* pointer, void (*deleter)(void*));
+
+template <typename T>
+void _retireObject(T* object)
+{
+    _retire(const_cast<void*>(static_cast<const void*>(object)), [](void* pointer) { delete static_cast<T*>(pointer); });
+}
+
+template <typename T>
+void _retireArray(T* array)
+{
+    _retire(const_cast<void*>(static_cast<const void*>(array)), [](void* pointer) { delete[] static_cast<T*>(pointer); });
+}
+
+// Attendo la fine degli emit in corso negli altri thread
+void _synchronize();
+
+// Il thread corrente è dentro un emit
+bool _inEpoch();
+
+#endif // SOBJECT_SEQLOCK_EMIT
+
 
 
 // =======================================
 //
-//                Slot
+//              Causality
+//
+// =======================================
+
+// Identificativo di causalità del thread corrente (0 se nessuno). Gli emit annidati lo ereditano
+// perché vengono eseguiti sullo stesso thread; le chiamate accodate lo copiano e lo ripristinano
+// nel thread dell'event loop
+inline std::uint64_t& _causality()
+{
+    static thread_local std::uint64_t id = 0;
+    return id;
+}
+
+
+
+#ifdef SOBJECT_THREAD_SAFE
+
+// =======================================
+//
+//                Task
 //
 // =======================================
 
+// Chiamata accodata nell'event loop di uno shard, è anche il nodo della sua coda MPSC
+class _Task
+{
+public:
+    virtual ~_Task() {};
+
+    // Restituisce false se il task è stato inoltrato a un altro shard (lo shard non deve più toccarlo)
+    virtual bool run()
+    {
+        return true;
+    }
+
+    // Chiamato dallo shard dopo run(), o al suo posto per i task rimasti alla chiusura del loop
+    virtual void dispose()
+    {
+        delete this;
+    }
+
+    std::atomic<_Task*> m_next{nullptr};
+};
+
+class _EventShard;
+class _Balancer;
+
+// Stato del receiver condiviso con i task accodati, sopravvive all'oggetto: flag di vita e shard corrente
+// (cambiato dalle migrazioni, i task rimasti nella coda del vecchio shard vengono inoltrati)
+struct _LoopState
+{
+    std::atomic<bool> alive{true};
+    std::atomic<_EventShard*> shard{nullptr};
+};
+
+// Shard in cui accodare una chiamata al receiver. Restituisce nullptr se la slot va eseguita subito:
+// receiver senza shard o, per le slot non idle, emit dal thread del suo stesso shard
+_EventShard* _queuedShard(const SObject* receiver, bool idle);
+
+// Stato del receiver: i task accodati non chiamano le slot di un oggetto distrutto
+std::shared_ptr<const _LoopState> _loopState(const SObject* receiver);
+
+// Inserisco il task nella coda dello shard (o in quella idle), lo shard ne diventa proprietario
+void _postTask(_EventShard* shard, _Task* task, bool idle);
+
+// Se il receiver è stato migrato in un altro shard rispetto a quello del thread corrente inoltro il task
+// nella sua coda e restituisco true
+bool _forwardTask(const _LoopState& state, _Task* task, bool idle);
+
+// Aggiungo o tolgo l'oggetto dal registro dello shard, letto dal ripartizionamento
+void _registerObject(_EventShard* shard, SObject* object, bool registered);
+
+// Chiamata a una slot con una copia dei parametri dell'emit
 template <typename Receiver, typename... Args>
-class _Slot : public _SlotBase<Args...>
+class _QueuedCall : public _Task
 {
 public:
-    // Anche se i costruttori sono pubblici non utilizzare le seguenti classi
-    _Slot() = delete;
-    _Slot(const _Slot&) = delete;
-    _Slot(Receiver* receiver, void(Receiver::*method)(Args...)) : m_receiver(receiver), m_method(method) {};
-    virtual ~_Slot() {};
+    _QueuedCall(Receiver* receiver, void(Receiver::*method)(Args...), bool idle, const typename std::decay<Args>::type&... args)
+        : m_state(_loopState(receiver)), m_receiver(receiver), m_method(method), m_args(args...), m_causality(_causality()), m_idle(idle) {};
 
+    virtual bool run() override
+    {
+        if(not m_state->alive.load(std::memory_order_acquire)) return true;
+        if(_forwardTask(*m_state, this, m_idle)) return false;
+
+        // La slot (e gli emit che effettua) vede la causalità dell'emit originale
+        std::uint64_t& causality     = _causality();
+        const std::uint64_t previous = causality;
+        causality                    = m_causality;
+
+        call(typename _MakeIndexSequence<sizeof...(Args)>::type());
+
+        causality = previous;
+        return true;
+    }
+
+private:
+    // La copia viene usata una sola volta, i parametri per valore la ricevono spostata
+    template <std::size_t... I>
+    void call(_IndexSequence<I...>)
+    {
+        (m_receiver->*m_method)(std::forward<Args>(std::get<I>(m_args))...);
+    }
+
+    const std::shared_ptr<const _LoopState> m_state;
+    Receiver* const m_receiver;
+    void(Receiver::* const m_method)(Args...);
+    std::tuple<typename std::decay<Args>::type...> m_args;
+    const std::uint64_t m_causality;
+    const bool m_idle;
+};
+
+#endif // SOBJECT_THREAD_SAFE
 
 
-    // ===============================
-    //
-    //  Override
 
-    // Confronto di due tramite puntatori (override)
-    virtual bool compareByPointer(const _SlotBase<Args...>* other) const override
+// =======================================
+//
+//               Future
+//
+// =======================================
+
+// Spazio per un valore costruito e distrutto esplicitamente: gli stati dei future vengono riusati
+template <typename T>
+class _Storage
+{
+public:
+    template <typename... Values>
+    void construct(Values&&... values)
     {
-        // Provo ad effettuare il cast
-        auto slot = dynamic_cast<const _Slot<Receiver, Args...>*>(other);
-        if(slot == nullptr) return false;
+        new(m_buffer) T(std::forward<Values>(values)...);
+    }
 
-        return m_receiver == slot->m_receiver and
-               m_method   == slot->m_method;
+    T& get()
+    {
+        return *reinterpret_cast<T*>(m_buffer);
     }
 
-    // Confronto tra ricevitori
-    virtual bool compareByReceiver(const SObject* receiver) const override
+    void destroy()
     {
-        return m_receiver == receiver;
+        get().~T();
+    }
+
+private:
+    alignas(T) unsigned char m_buffer[sizeof(T)];
+};
+
+// Continuazione di un future: le callable piccole stanno nel buffer interno, le altre nello heap
+class _Continuation
+{
+public:
+    _Continuation() {};
+    _Continuation(const _Continuation&) = delete;
+
+    ~_Continuation()
+    {
+        reset();
+    }
+
+    template <typename Fn>
+    void set(Fn&& fn)
+    {
+        typedef typename std::decay<Fn>::type Callable;
+
+        if(sizeof(Callable) <= sizeof(m_buffer) and alignof(Callable) <= alignof(std::max_align_t))
+        {
+            new(m_buffer) Callable(std::forward<Fn>(fn));
+            m_call    = &callInline<Callable>;
+            m_destroy = &destroyInline<Callable>;
+        }
+        else
+        {
+            new(m_buffer) Callable*(new Callable(std::forward<Fn>(fn)));
+            m_call    = &callHeap<Callable>;
+            m_destroy = &destroyHeap<Callable>;
+        }
+    }
+
+    void operator()()
+    {
+        m_call(m_buffer);
+    }
+
+    void reset()
+    {
+        if(m_destroy != nullptr) m_destroy(m_buffer);
+        m_call    = nullptr;
+        m_destroy = nullptr;
+    }
+
+private:
+    template <typename Callable>
+    static void callInline(void* buffer)
+    {
+        (*static_cast<Callable*>(buffer))();
+    }
+
+    template <typename Callable>
+    static void destroyInline(void* buffer)
+    {
+        static_cast<Callable*>(buffer)->~Callable();
+    }
+
+    template <typename Callable>
+    static void callHeap(void* buffer)
+    {
+        (**static_cast<Callable**>(buffer))();
+    }
+
+    template <typename Callable>
+    static void destroyHeap(void* buffer)
+    {
+        delete *static_cast<Callable**>(buffer);
+    }
+
+    void (*m_call)(void*)    = nullptr;
+    void (*m_destroy)(void*) = nullptr;
+    alignas(std::max_align_t) unsigned char m_buffer[48];
+};
+
+// Stato condiviso di un future, senza il valore. Il riferimento del future e quello della chiamata
+// (o della continuazione) sono contati, l'ultimo che lo rilascia lo restituisce al pool.
+// In modalità thread safe è anche il task accodato nello shard del receiver
+class _FutureCore
+#ifdef SOBJECT_THREAD_SAFE
+    : public _Task
+#endif
+{
+public:
+    _FutureCore() {};
+    _FutureCore(const _FutureCore&) = delete;
+    virtual ~_FutureCore() {};
+
+    bool isReady() const
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        return m_stage.load(std::memory_order_acquire) == Ready;
+#else
+        return m_stage == Ready;
+#endif
+    }
+
+    // Valido solo quando lo stato è pronto
+    bool isCancelled() const
+    {
+        return m_cancelled;
+    }
+
+    // Valido solo quando lo stato è pronto: il metodo è terminato con un'eccezione
+    bool hasFailed() const
+    {
+        return m_exception != nullptr;
+    }
+
+    // Attendo che lo stato sia pronto
+    void wait() const;
+
+    // Registro la continuazione, chiamata dal thread che completa lo stato. Restituisce false se lo stato
+    // è già pronto: la continuazione resta registrata, il chiamante la esegue con resume() o la scarta
+    template <typename Fn>
+    bool suspend(Fn&& fn, bool ownsReference)
+    {
+        m_continuation.set(std::forward<Fn>(fn));
+        m_ownsReference = ownsReference;
+
+        return park();
+    }
+
+    // Eseguo e scarto la continuazione registrata
+    void resume();
+
+    void discardContinuation()
+    {
+        m_continuation.reset();
+    }
+
+    // Preparo uno stato preso dal pool con il numero di riferimenti iniziali
+    void prepare(unsigned references);
+
+    // Pubblico il risultato (già scritto) e chiamo la continuazione registrata
+    void complete(bool cancelled);
+
+    void release();
+
+    // Lista libera del pool
+    _FutureCore* m_nextFree = nullptr;
+
+protected:
+    // Distruggo valore e parametri e restituisco lo stato al suo pool
+    virtual void recycle() = 0;
+
+    void fail(std::exception_ptr exception)
+    {
+        m_exception = exception;
     }
 
-    // Getter receiver
-    virtual SObject* getReceiver() const override
-    {
-        return m_receiver;
-    }
+    // Rilancio l'eccezione del metodo, se è terminato con un'eccezione
+    void rethrowFailure() const
+    {
+        if(m_exception != nullptr) std::rethrow_exception(m_exception);
+    }
+
+    void clearFailure()
+    {
+        m_exception = nullptr;
+    }
+
+private:
+    enum Stage : unsigned { Pending, Waiting, Ready };
+
+    bool park();
+
+#ifdef SOBJECT_THREAD_SAFE
+    std::atomic<unsigned> m_stage{Pending};
+    std::atomic<unsigned> m_references{0};
+#else
+    unsigned m_stage      = Pending;
+    unsigned m_references = 0;
+#endif
+    bool m_cancelled     = false;
+    bool m_ownsReference = false;
+    std::exception_ptr m_exception;
+    _Continuation m_continuation;
+};
+
+// Stato con il valore restituito dal metodo
+template <typename T>
+class _FutureState : public _FutureCore
+{
+public:
+    // Rilancia l'eccezione del metodo, se è terminato con un'eccezione
+    T take()
+    {
+        rethrowFailure();
+        return std::move(m_value.get());
+    }
+
+    template <typename Fn>
+    void apply(Fn& fn)
+    {
+        fn(std::move(m_value.get()));
+    }
+
+    // Un'eccezione del metodo non esce dal loop del receiver (né da invoke): resta nello stato
+    // e il valore viene costruito di default, come per una chiamata annullata
+    template <typename Call>
+    void store(Call&& call)
+    {
+        try
+        {
+            m_value.construct(call());
+        }
+        catch(...)
+        {
+            m_value.construct();
+            fail(std::current_exception());
+        }
+    }
+
+    // Una chiamata annullata restituisce un valore costruito di default
+    void cancel()
+    {
+        m_value.construct();
+    }
+
+protected:
+    void clearValue()
+    {
+        m_value.destroy();
+        clearFailure();
+    }
+
+private:
+    _Storage<T> m_value;
+};
+
+template <>
+class _FutureState<void> : public _FutureCore
+{
+public:
+    void take()
+    {
+        rethrowFailure();
+    }
+
+    template <typename Fn>
+    void apply(Fn& fn)
+    {
+        fn();
+    }
+
+    template <typename Call>
+    void store(Call&& call)
+    {
+        try
+        {
+            call();
+        }
+        catch(...)
+        {
+            fail(std::current_exception());
+        }
+    }
+
+    void cancel() {}
+
+protected:
+    void clearValue()
+    {
+        clearFailure();
+    }
+};
+
+// Pool degli stati di un tipo: la lista libera riusa gli stati rilasciati, così una invoke a regime
+// non alloca. Il pool non viene mai distrutto, gli stati possono tornare anche dopo la fine del main
+template <typename State>
+class _FuturePool
+{
+public:
+    static State* acquire()
+    {
+        _FuturePool& pool = instance();
+        {
+#ifdef SOBJECT_THREAD_SAFE
+            _SpinGuard guard(pool.m_lock);
+#endif
+            if(pool.m_free != nullptr)
+            {
+                State* state = static_cast<State*>(pool.m_free);
+                pool.m_free  = state->m_nextFree;
+                --pool.m_size;
+                return state;
+            }
+        }
+
+        return new State();
+    }
+
+    static void recycle(State* state)
+    {
+        _FuturePool& pool = instance();
+        {
+#ifdef SOBJECT_THREAD_SAFE
+            _SpinGuard guard(pool.m_lock);
+#endif
+            if(pool.m_size < Capacity)
+            {
+                state->m_nextFree = pool.m_free;
+                pool.m_free       = state;
+                ++pool.m_size;
+                return;
+            }
+        }
+
+        delete state;
+    }
+
+private:
+    static _FuturePool& instance()
+    {
+        static _FuturePool* const pool = new _FuturePool();
+        return *pool;
+    }
+
+    // Stati tenuti nella lista libera, oltre vengono eliminati
+    static const std::size_t Capacity = 1024;
+
+    _FutureCore* m_free = nullptr;
+    std::size_t m_size  = 0;
+#ifdef SOBJECT_THREAD_SAFE
+    _SpinLock m_lock;
+#endif
+};
+
+// Chiamata di un metodo del receiver con una copia dei parametri, eseguita nel suo shard.
+// Lo stato del future e il task accodato sono lo stesso oggetto, preso dal pool
+template <typename Value, typename Receiver, typename Method, typename... Params>
+class _InvokeCall : public _FutureState<Value>
+{
+public:
+    // Chiamata diretta nel thread corrente
+    template <typename... Args>
+    void execute(Receiver* receiver, Method method, Args&&... args)
+    {
+        this->store([&] { return (receiver->*method)(std::forward<Args>(args)...); });
+        this->complete(false);
+    }
+
+#ifdef SOBJECT_THREAD_SAFE
+    // Copio i parametri per la chiamata accodata
+    template <typename... Args>
+    void bind(Receiver* receiver, Method method, Args&&... args)
+    {
+        m_state     = _loopState(receiver);
+        m_receiver  = receiver;
+        m_method    = method;
+        m_causality = _causality();
+        m_args.construct(std::forward<Args>(args)...);
+        m_bound = true;
+    }
+
+    virtual bool run() override
+    {
+        if(not m_state->alive.load(std::memory_order_acquire))
+        {
+            this->cancel();
+            this->complete(true);
+            return true;
+        }
+
+        if(_forwardTask(*m_state, this, false)) return false;
+
+        // Il metodo (e gli emit che effettua) vede la causalità della invoke
+        std::uint64_t& causality     = _causality();
+        const std::uint64_t previous = causality;
+        causality                    = m_causality;
+
+        this->store([this] { return call(typename _MakeIndexSequence<sizeof...(Params)>::type()); });
+
+        causality = previous;
+        this->complete(false);
+        return true;
+    }
+
+    // Task scartato senza eseguirlo (loop chiuso): il future risulta annullato
+    virtual void dispose() override
+    {
+        if(not this->isReady())
+        {
+            this->cancel();
+            this->complete(true);
+        }
+
+        this->release();
+    }
+#endif
+
+protected:
+    virtual void recycle() override
+    {
+        this->clearValue();
+
+#ifdef SOBJECT_THREAD_SAFE
+        if(m_bound)
+        {
+            m_args.destroy();
+            m_state.reset();
+            m_bound = false;
+        }
+#endif
+
+        _FuturePool<_InvokeCall>::recycle(this);
+    }
+
+#ifdef SOBJECT_THREAD_SAFE
+private:
+    // La copia viene usata una sola volta, i parametri per valore la ricevono spostata
+    template <std::size_t... I>
+    Value call(_IndexSequence<I...>)
+    {
+        return (m_receiver->*m_method)(std::forward<Params>(std::get<I>(m_args.get()))...);
+    }
+
+    std::shared_ptr<const _LoopState> m_state;
+    Receiver* m_receiver = nullptr;
+    Method m_method      = nullptr;
+    std::uint64_t m_causality = 0;
+    _Storage<std::tuple<typename std::decay<Params>::type...>> m_args;
+    bool m_bound = false;
+#endif
+};
+
+
+
+// =======================================
+//
+//              SlotGroup
+//
+// =======================================
+
+// Gruppi di esecuzione delle slot, nell'ordine in cui vengono chiamate
+enum _SlotGroup : std::size_t
+{
+    _PreGroup     = 0,
+    _DefaultGroup = 1,
+    _PostGroup    = 2,
+    _GroupCount   = 3
+};
+
+
+
+// =======================================
+//
+//              MethodKey
+//
+// =======================================
+
+// Indirizzo univoco per ogni tipo (identifica il tipo del puntatore a metodo)
+template <typename T>
+struct _TypeTag
+{
+    static const char id;
+};
+
+template <typename T>
+const char _TypeTag<T>::id = 0;
+
+// Chiave non template di un puntatore a metodo: tipo del puntatore e suoi byte.
+// Sostituisce il confronto tramite dynamic_cast e oggetti temporanei
+struct _MethodKey
+{
+    bool operator==(const _MethodKey& other) const
+    {
+        return m_type == other.m_type and std::memcmp(m_method, other.m_method, sizeof(m_method)) == 0;
+    }
+
+    std::size_t hash() const;
+
+    const void* m_type = nullptr;
+    unsigned char m_method[3 * sizeof(void*)] = {};
+};
+
+template <typename Method>
+_MethodKey _makeMethodKey(Method method)
+{
+    static_assert(sizeof(Method) <= sizeof(_MethodKey::m_method), "Puntatore a metodo troppo grande per _MethodKey");
+
+    _MethodKey key;
+    key.m_type = &_TypeTag<Method>::id;
+    std::memcpy(key.m_method, &method, sizeof(Method));
+    return key;
+}
+
+
+
+// =======================================
+//
+//             RateLimiter
+//
+// =======================================
+
+// Tick del contatore di tempo: TSC sulle CPU x86 (invariante sulle CPU moderne), altrove steady_clock
+inline std::uint64_t _ticks()
+{
+#if defined(__x86_64__) or defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Tick al secondo, misurati una sola volta alla prima chiamata
+double _ticksPerSecond();
+
+// Token bucket nella forma GCRA: un solo istante teorico di arrivo al posto del numero di token.
+// Una chiamata viene accettata se non anticipa quell'istante di oltre la tolleranza della raffica;
+// il controllo è una lettura del TSC, un confronto e una somma
+class _RateLimiter
+{
+public:
+    _RateLimiter(const SRateLimit& limit);
+    _RateLimiter(const _RateLimiter&) = delete;
+
+    // Limite utilizzabile: perSecond > 0 e burst >= 1 (NaN escluso)
+    static bool isValid(const SRateLimit& limit)
+    {
+        return limit.perSecond > 0 and limit.burst >= 1;
+    }
+
+    // Nuovo limite con gli stessi parametri e lo stato azzerato (connect clonate da un prefab)
+    _RateLimiter* clone() const
+    {
+        return new _RateLimiter(m_interval, m_tolerance);
+    }
+
+    bool acquire()
+    {
+        const std::uint64_t now = _ticks();
+
+#ifdef SOBJECT_THREAD_SAFE
+        // Emit concorrenti sulla stessa slot: aggiorno l'istante con una CAS
+        std::uint64_t arrival = m_arrival.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            const std::uint64_t start = arrival > now ? arrival : now;
+            if(start - now > m_tolerance)
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            if(m_arrival.compare_exchange_weak(arrival, start + m_interval, std::memory_order_relaxed)) return true;
+        }
+#else
+        const std::uint64_t start = m_arrival > now ? m_arrival : now;
+        if(start - now > m_tolerance)
+        {
+            ++m_dropped;
+            return false;
+        }
+
+        m_arrival = start + m_interval;
+        return true;
+#endif
+    }
+
+    std::uint64_t dropped() const
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        return m_dropped.load(std::memory_order_relaxed);
+#else
+        return m_dropped;
+#endif
+    }
+
+private:
+    _RateLimiter(std::uint64_t interval, std::uint64_t tolerance) : m_interval(interval), m_tolerance(tolerance) {};
+
+    // Tick tra due chiamate e anticipo massimo concesso (burst - 1 intervalli)
+    const std::uint64_t m_interval;
+    const std::uint64_t m_tolerance;
+
+#ifdef SOBJECT_THREAD_SAFE
+    std::atomic<std::uint64_t> m_arrival{0};
+    std::atomic<std::uint64_t> m_dropped{0};
+#else
+    std::uint64_t m_arrival = 0;
+    std::uint64_t m_dropped = 0;
+#endif
+};
+
+
+
+// =======================================
+//
+//              SlotCore
+//
+// =======================================
+
+// Puntatore a funzione senza tipo, riconvertito nella firma originale dal segnale
+typedef void (*_ErasedCall)();
+
+class _SignalBase;
+
+class _SlotCore
+{
+protected:
+    // Costruttori protected in modo che solo Slot possa creare oggetti di questo tipo
+    _SlotCore(SObject* receiver, const _MethodKey& key, SConnectionType type) : m_receiver(receiver), m_key(key), m_type(type) {};
+    _SlotCore(const _SlotCore&) = delete;
+
+public:
+    // Il distruttore rimuove la connect dal receiver
+    virtual ~_SlotCore();
+
+
+
+    // ===============================
+    //
+    //  Confronti
+
+public:
+    // Confronto di due slot tramite (receiver, metodo)
+    bool compareByPointer(const _SlotCore* other) const
+    {
+        return m_receiver == other->m_receiver and m_key == other->m_key;
+    }
+
+    // Confronto tra ricevitori
+    bool compareByReceiver(const SObject* receiver) const
+    {
+        return m_receiver == receiver;
+    }
+
+    // Getter receiver
+    SObject* getReceiver() const
+    {
+        return m_receiver;
+    }
+
+    // Hash della coppia (receiver, metodo)
+    std::size_t hash() const;
+
+
+
+    // ===============================
+    //
+    //  Connessione con il receiver
+
+public:
+    // Registro l'emitter nel receiver (e la slot nel modulo), le voci appartengono alla slot
+    void link(SObject* emitter, SModuleToken* module = nullptr);
+
+    // Rimuovo le voci dal receiver e dal modulo in O(1). Con notify il receiver viene
+    // avvisato che la connect è stata rimossa senza essere eseguita
+    void unlink(bool notify = true);
+
+    // Segnale che contiene la slot, posizione nella sua lista e numero progressivo della connect nel segnale (impostati da addSlot)
+    void place(_SignalBase* signal, std::list<_SlotCore*>::iterator position, std::size_t serial)
+    {
+        m_signal   = signal;
+        m_position = position;
+        m_serial   = serial;
+    }
+
+    _SignalBase* signal() const
+    {
+        return m_signal;
+    }
+
+    SObject* emitter() const
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        return m_emitter.load(std::memory_order_relaxed);
+#else
+        return m_emitter;
+#endif
+    }
+
+    // Spostamento di un SObject: la connect passa al nuovo emitter senza essere ricreata
+    void setEmitter(SObject* emitter)
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        m_emitter.store(emitter, std::memory_order_relaxed);
+#else
+        m_emitter = emitter;
+#endif
+    }
+
+    // Spostamento di un SObject: cambio il receiver (chiamato solo da _SignalBase::moveReceiver, che aggiorna l'indice)
+    void setReceiver(SObject* receiver)
+    {
+        m_receiver = receiver;
+    }
+
+    std::list<_SlotCore*>::iterator position() const
+    {
+        return m_position;
+    }
+
+    // Gli emit chiamano solo le slot con un numero minore di quello del segnale al loro inizio
+    std::size_t serial() const
+    {
+        return m_serial;
+    }
+
+    // Slot rimossa mentre un emit scorreva il segnale: resta in vita fino alla fine dell'emit
+    // e position() indica la slot che la seguiva, da cui l'emit riprende
+    bool isRemoved() const
+    {
+        return m_removed;
+    }
+
+    void setRemoved(std::list<_SlotCore*>::iterator next)
+    {
+        m_removed  = true;
+        m_position = next;
+    }
+
+    // Posizione della slot nell'array dei receiver del segnale (impostata dal segnale)
+    std::size_t receiverIndex() const
+    {
+        return m_receiverIndex;
+    }
+
+    void setReceiverIndex(std::size_t index)
+    {
+        m_receiverIndex = index;
+    }
+
+    SConnectionType type() const { return m_type; }
+    bool isSingleShot() const { return m_type & SSingleShotConnection; }
+    bool isDeferred() const   { return m_type & (SQueuedConnection | SIdleConnection); }
+    bool isIdle() const       { return m_type & SIdleConnection; }
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Posizione della slot nello snapshot del segnale, dove la rimozione segna il suo bit
+    std::size_t snapshotIndex() const
+    {
+        return m_snapshotIndex;
+    }
+
+    void setSnapshotIndex(std::size_t index)
+    {
+        m_snapshotIndex = index;
+    }
+#endif
+
+    // Funzione che chiama la slot senza passare dal metodo virtuale (usata dai programmi di dispatch)
+    virtual _ErasedCall call() const = 0;
+
+    // Nuova slot con lo stesso metodo, tipo di connect e filtri, verso un altro receiver (usata dai prefab)
+    virtual _SlotCore* clone(SObject* receiver) const = 0;
+
+    _SlotGroup group() const
+    {
+        if(m_type & SPreConnection)  return _PreGroup;
+        if(m_type & SPostConnection) return _PostGroup;
+        return _DefaultGroup;
+    }
+
+
+
+    // ===============================
+    //
+    //  Filtri (campionamento e limite di chiamate)
+
+public:
+    // Imposto i filtri della connect (prima di aggiungere la slot al segnale)
+    void setRateLimit(const SRateLimit& limit);
+    void setSampling(const SSampling& sampling);
+
+    // Copio i filtri di un'altra slot, con lo stato azzerato
+    void copyFilters(const _SlotCore& other);
+
+    // La slot ha un filtro da controllare prima di ogni chiamata
+    bool isFiltered() const
+    {
+        return m_filtered;
+    }
+
+    // Chiamate scartate dal limite
+    std::uint64_t droppedCount() const
+    {
+        return m_limiter != nullptr ? m_limiter->dropped() : 0;
+    }
+
+protected:
+    // Controllo i filtri: prima il campionamento (un incremento e un confronto), poi il limite
+    bool admit()
+    {
+        if(m_sampleEvery != 0 and not sample()) return false;
+        return m_limiter == nullptr or m_limiter->acquire();
+    }
+
+private:
+    bool sample()
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        // Load e store senza RMW: con emit concorrenti qualche conteggio può andare perso
+        std::uint32_t state = m_sampleState.load(std::memory_order_relaxed);
+#else
+        std::uint32_t state = m_sampleState;
+#endif
+
+        bool taken = false;
+        if(m_sampleRandom)
+        {
+            // Xorshift a 32 bit, accetto l'emit se il valore è sotto la soglia (1 su m_sampleEvery)
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            taken = state <= m_sampleThreshold;
+        }
+        else if(++state >= m_sampleEvery)
+        {
+            state = 0;
+            taken = true;
+        }
+
+#ifdef SOBJECT_THREAD_SAFE
+        m_sampleState.store(state, std::memory_order_relaxed);
+#else
+        m_sampleState = state;
+#endif
+        return taken;
+    }
+
+
+
+#ifdef SOBJECT_THREAD_SAFE
+    // ===============================
+    //
+    //  Traffico delle connect accodate
+
+public:
+    // Conto una chiamata accodata (load e store senza RMW come il campionamento, qualche conteggio può andare perso)
+    void countTraffic()
+    {
+        m_traffic.store(m_traffic.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Chiamate dall'ultima lettura, usate dal ripartizionamento degli oggetti tra gli shard
+    std::uint32_t takeTraffic()
+    {
+        return m_traffic.exchange(0, std::memory_order_relaxed);
+    }
+#endif
+
+
+
+#ifdef SOBJECT_THREAD_SAFE
+    // ===============================
+    //
+    //  Risorse della slot (SSlotScheduler)
+
+public:
+    // Imposto le risorse dichiarate nella connect (prima di aggiungere la slot al segnale)
+    void setAccess(const SAccess& access)
+    {
+        m_reads  = access.reads;
+        m_writes = access.writes;
+    }
+
+    // Una slot senza risorse dichiarate le scrive tutte: lo scheduler non la esegue insieme ad altre
+    std::uint64_t reads() const
+    {
+        return m_reads;
+    }
+
+    std::uint64_t writes() const
+    {
+        return m_writes;
+    }
+#endif
+
+
+
+    // ===============================
+    //
+    //  SlotHash / SlotEqual
+
+public:
+    // Funzioni per l'indice hash (receiver, metodo) delle slot di un segnale
+    struct SlotHash
+    {
+        std::size_t operator()(const _SlotCore* slot) const
+        {
+            return slot->hash();
+        }
+    };
+
+    struct SlotEqual
+    {
+        bool operator()(const _SlotCore* first, const _SlotCore* second) const
+        {
+            return first->compareByPointer(second);
+        }
+    };
+
+
+
+    // ===============================
+    //
+    //  Variabili
+
+protected:
+    // Non costante: lo spostamento del receiver aggiorna la connect sul posto
+    SObject* m_receiver;
+
+    // Campionamento o limite di chiamate impostati
+    bool m_filtered = false;
+
+private:
+    // Limite di chiamate della connect (nullptr se non limitata)
+    _RateLimiter* m_limiter = nullptr;
+
+    // Campionamento: un emit ogni m_sampleEvery (0 se disattivo), o a caso sotto m_sampleThreshold.
+    // Il contatore (o lo stato del generatore casuale) sta nel nodo della connect
+    std::uint32_t m_sampleEvery = 0;
+    std::uint32_t m_sampleThreshold = 0;
+    bool m_sampleRandom = false;
+#ifdef SOBJECT_THREAD_SAFE
+    std::atomic<std::uint32_t> m_sampleState{0};
+
+    // Chiamate accodate dall'ultimo campionamento del traffico
+    std::atomic<std::uint32_t> m_traffic{0};
+
+    // Risorse lette e scritte dalla slot (bit di SAccess)
+    std::uint64_t m_reads  = 0;
+    std::uint64_t m_writes = ~std::uint64_t(0);
+#else
+    std::uint32_t m_sampleState = 0;
+#endif
+
+    const _MethodKey m_key;
+    const SConnectionType m_type;
+    bool m_linked = false;
+    bool m_removed = false;
+    std::list<_SlotCore*>::iterator m_receiverEntry;
+
+#ifdef SOBJECT_THREAD_SAFE
+    // Letto senza lock dello stripe (distruzione del receiver, disconnectModule) e cambiato dallo spostamento
+    std::atomic<SObject*> m_emitter{nullptr};
+#else
+    SObject* m_emitter = nullptr;
+#endif
+
+    // Modulo proprietario della connect (nullptr se non indicato)
+    SModuleToken* m_module = nullptr;
+    std::list<_SlotCore*>::iterator m_moduleEntry;
+
+    _SignalBase* m_signal = nullptr;
+    std::list<_SlotCore*>::iterator m_position;
+    std::size_t m_serial = 0;
+    std::size_t m_receiverIndex = 0;
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    std::size_t m_snapshotIndex = 0;
+#endif
+};
+
+
+
+// =======================================
+//
+//              SlotBase
+//
+// =======================================
+
+template <typename... Args>
+class _SlotBase : public _SlotCore
+{
+protected:
+    // Costruttori protected in modo che solo Slot possa creare oggetti di questo tipo
+    _SlotBase(SObject* receiver, const _MethodKey& key, SConnectionType type) : _SlotCore(receiver, key, type) {};
+
+public:
+    typedef void (*Call)(_SlotCore*, Args&&...);
+
+    virtual void exec(Args&&...) = 0;
+};
+
+
+
+// =======================================
+//
+//                Slot
+//
+// =======================================
+
+template <typename Receiver, typename... Args>
+class _Slot : public _SlotBase<Args...>
+{
+public:
+    // Anche se i costruttori sono pubblici non utilizzare le seguenti classi
+    _Slot() = delete;
+    _Slot(const _Slot&) = delete;
+    _Slot(Receiver* receiver, void(Receiver::*method)(Args...), SConnectionType type = SDefaultConnection)
+        : _SlotBase<Args...>(receiver, _makeMethodKey(method), type), m_method(method) {};
+
+
+
+    // ===============================
+    //
+    //  Override
+
+    // Metodo per eseguire la slot
+    virtual void exec(Args&&... args) override
+    {
+        // Emit escluso dal campionamento o oltre il limite della connect: lo scarto
+        if(this->m_filtered and not this->admit()) return;
+
+#ifdef SOBJECT_THREAD_SAFE
+        // Connect accodata verso un receiver di un altro shard (o idle): la chiamata passa dalla coda dello shard
+        if(this->isDeferred())
+        {
+            this->countTraffic();
+
+            if(_EventShard* shard = _queuedShard(this->m_receiver, this->isIdle()))
+            {
+                _postTask(shard, new _QueuedCall<Receiver, Args...>(static_cast<Receiver*>(this->m_receiver), m_method, this->isIdle(), args...), this->isIdle());
+                return;
+            }
+        }
+#endif
+
+        (static_cast<Receiver*>(this->m_receiver)->*m_method)(std::forward<Args>(args)...);
+    }
+
+    virtual _ErasedCall call() const override
+    {
+        return reinterpret_cast<_ErasedCall>(&_Slot::invoke);
+    }
+
+    virtual _SlotCore* clone(SObject* receiver) const override
+    {
+        _Slot* slot = new _Slot(static_cast<Receiver*>(receiver), m_method, this->type());
+        slot->copyFilters(*this);
+        return slot;
+    }
+
+
+
+    // ===============================
+    //
+    //  Chiamata diretta
+
+private:
+    static void invoke(_SlotCore* slot, Args&&... args)
+    {
+        _Slot* self = static_cast<_Slot*>(slot);
+        (static_cast<Receiver*>(self->m_receiver)->*self->m_method)(std::forward<Args>(args)...);
+    }
+
+
+
+    // ===============================
+    //
+    //  Variabili
+
+private:
+    void(Receiver::*m_method)(Args...);
+};
+
+
+
+// =======================================
+//
+//              SharedArg
+//
+// =======================================
+
+// Parametro di un emit passato a una slot che non è l'ultima a riceverlo: exec inoltra i parametri
+// e una slot potrebbe spostarli, quindi quelli per valore vengono copiati per ogni slot
+// e i riferimenti puntano al valore condiviso. Solo l'ultima slot riceve il parametro inoltrato
+template <typename Arg>
+struct _SharedArg
+{
+    static typename std::decay<Arg>::type pass(const typename std::decay<Arg>::type& value)
+    {
+        return value;
+    }
+};
+
+template <typename Arg>
+struct _SharedArg<Arg&>
+{
+    static Arg& pass(Arg& value)
+    {
+        return value;
+    }
+};
+
+
+
+// =======================================
+//
+//              ReplayBase
+//
+// =======================================
+
+class _ReplayBase
+{
+public:
+    virtual ~_ReplayBase() {};
+    virtual void record(const void* const* argv) = 0;
+    virtual bool replay(_SlotCore* slot, bool onlyLast) = 0;
+};
+
+
+
+// =======================================
+//
+//              SignalBase
+//
+// =======================================
+
+class _Flow;
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+// Tabella immutabile dei segnali di un emitter, letta dagli emit senza lock
+struct _SignalTable
+{
+    std::vector<_SignalBase*> signals;
+};
+
+// Indice del bit a 1 meno significativo (bits diverso da zero)
+inline unsigned _lowestBit(std::uint64_t bits)
+{
+#if defined(__GNUC__) or defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+    unsigned index = 0;
+    for(; not (bits & 1); bits >>= 1) ++index;
+    return index;
+#endif
+}
+
+// Indice del bit a 1 più significativo (bits diverso da zero)
+inline unsigned _highestBit(std::uint64_t bits)
+{
+#if defined(__GNUC__) or defined(__clang__)
+    return 63 - static_cast<unsigned>(__builtin_clzll(bits));
+#else
+    unsigned index = 0;
+    while(bits >>= 1) ++index;
+    return index;
+#endif
+}
+#endif
+
+class _SignalBase
+{
+public:
+    typedef std::list<_SlotCore*> SlotList;
+
+    // Istruzione del programma di dispatch: chiamata diretta di una slot
+    struct Thunk
+    {
+        SlotList::iterator position;
+        _SlotCore* slot;
+        _ErasedCall call;
+    };
+
+protected:
+    // Costruttori protected in modo che solo Signal possa creare oggetti di questo tipo
+    _SignalBase(const _MethodKey& key);
+    _SignalBase(const _SignalBase&) = delete;
+
+public:
+    // Il distruttore elimina tutte le slot
+    virtual ~_SignalBase();
+
+
+
+    // ===============================
+    //
+    //  Confronti
+
+public:
+    bool compareByKey(const _MethodKey& key) const
+    {
+        return m_key == key;
+    }
+
+    bool compareByPointer(const _SignalBase* other) const
+    {
+        return m_key == other->m_key;
+    }
+
+    const _MethodKey& key() const
+    {
+        return m_key;
+    }
+
+
+
+    // ===============================
+    //
+    //  Interfacce esterne
+
+public:
+    // Inserisco la slot in coda al suo gruppo, così l'emit resta una scansione lineare
+    void addSlot(_SlotCore* slot);
+
+    // Inserisco più slot con una sola invalidazione (e una sola pubblicazione dello snapshot)
+    void addSlots(const std::vector<_SlotCore*>& slots);
+
+    // Nuovo segnale vuoto con la stessa chiave e lo stesso tipo (usato dai prefab)
+    virtual _SignalBase* cloneEmpty() const = 0;
+
+    const SlotList& slots() const
+    {
+        return m_slots;
+    }
+
+    // Numero progressivo della prossima connect: le connect effettuate durante un emit (anche dalle sue slot)
+    // hanno un numero maggiore o uguale a quello letto all'inizio dell'emit e non vengono chiamate da lui
+    std::size_t nextSerial() const
+    {
+        return m_nextSerial;
+    }
+
+    // Controllo tramite indice hash se la slot (receiver, metodo) è già connessa
+    bool containsSlot(const _SlotCore* slot);
+
+    // Rimuovo tutte le slot uguali a quella in input o appartenenti al receiver
+    void removeSlot(const _SlotCore* slot);
+    void removeSlotByReceiver(const SObject* receiver);
+
+    // Elimino una slot specifica in O(1) tramite la posizione salvata nella slot
+    void eraseSlot(_SlotCore* slot);
+
+    // Spostamento dell'emitter: le slot puntano al nuovo indirizzo e i flussi che lo hanno registrato vengono invalidati
+    void moveEmitter(SObject* emitter);
+
+    // Spostamento del receiver di una slot, la sposto nell'indice hash (la chiave contiene il receiver)
+    void moveReceiver(_SlotCore* slot, SObject* receiver);
+
+    // Rimuovo tutte le slot mantenendo il segnale
+    void removeAllSlots();
+
+    bool connectedWithObject(const SObject* receiver) const;
+    std::list<SObject*> getAllReceivers() const;
+
+    // Un segnale con buffer di replay mantiene lo stato anche senza slot
+    bool hasReplay() const
+    {
+        return m_replay != nullptr;
+    }
+
+    // Imposto il buffer di replay (nullptr lo disabilita), il segnale ne diventa proprietario
+    void setReplay(_ReplayBase* replay);
+
+    // Consegno alla slot l'ultimo valore o tutto il buffer
+    bool replay(_SlotCore* slot, bool onlyLast)
+    {
+        return m_replay != nullptr and m_replay->replay(slot, onlyLast);
+    }
+
+    // Le slot single shot modificano la lista durante l'emit
+    bool hasSingleShots() const
+    {
+        return m_singleShots != 0;
+    }
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Leggo lo snapshot delle slot (array, bitmap delle rimosse e numero di elementi, salvati nel segnale)
+    // sotto seqlock: se uno scrittore lo ha pubblicato nel frattempo riprovo. Nessuna scrittura atomica RMW.
+    // Restituisce false se il segnale deve essere emesso con il lock (slot single shot o replay)
+    bool readSnapshot(_SlotCore* const*& slots, const std::atomic<std::uint64_t>*& removed, std::size_t& count) const
+    {
+        for(;;)
+        {
+            const unsigned sequence = m_sequence.load(std::memory_order_acquire);
+            if(sequence & 1) continue;
+
+            slots   = m_readSlots.load(std::memory_order_relaxed);
+            removed = m_readRemoved.load(std::memory_order_relaxed);
+            count   = m_readCount.load(std::memory_order_relaxed);
+            const bool locked = m_readLocked.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(m_sequence.load(std::memory_order_relaxed) == sequence) return not locked;
+        }
+    }
+#endif
+
+    // Un segnale con buffer di replay o flusso compilato non viene eliminato dalla disconnect
+    bool isPersistent() const
+    {
+        return m_replay != nullptr or m_flow != nullptr;
+    }
+
+    // Flusso compilato che parte da questo segnale (nullptr se non abilitato)
+    _Flow* flow() const
+    {
+        return m_flow;
+    }
+
+    // Imposto il flusso compilato (nullptr lo disabilita), il segnale ne diventa proprietario
+    void setFlow(_Flow* flow);
+
+    // Registro un flusso che attraversa il segnale, verrà invalidato a ogni modifica delle slot
+    void addDependentFlow(_Flow* flow);
+    void removeDependentFlow(_Flow* flow);
+
+    // Trasformo la lista delle slot in un array di chiamate dirette.
+    // I segnali con slot single shot o limitate restano sulla scansione della lista
+    void compile();
+
+    // Chiamate scartate dal limite, sommate sulle slot uguali a quella in input
+    std::uint64_t droppedCount(const _SlotCore* slot) const;
+
+    // Elimino il segnale, già tolto dall'emitter. Se un emit lo sta scorrendo (una sua slot ha rimosso
+    // il segnale, o il thread dell'emit attende un lock) tolgo le slot e lo elimina l'ultimo emit che termina
+    void dispose();
+
+
+
+    // ===============================
+    //
+    //  Scansione delle slot
+
+public:
+    // Inizio e fine di un emit che scorre le slot (vedi _IterationScope)
+#ifdef SOBJECT_THREAD_SAFE
+    void beginIteration();
+    void endIteration();
+
+    // Il segnale è scorso da un emit di un altro thread, fermo in attesa di un lock
+    bool iteratedElsewhere() const;
+#else
+    void beginIteration()
+    {
+        ++m_iterations;
+    }
+
+    void endIteration()
+    {
+        // Alla fine dell'ultimo emit elimino le slot trattenute, o il segnale se è stato rimosso
+        if(--m_iterations != 0) return;
+
+        if(m_orphaned)
+        {
+            delete this;
+        }
+        else if(not m_retainedSlots.empty())
+        {
+            releaseRetained();
+        }
+    }
+#endif
+
+    // Posizione da cui l'emit prosegue dopo aver chiamato la slot in slotIt. Se la slot è stata
+    // rimossa durante la chiamata riprendo dalla slot che la seguiva, rimossa a sua volta o ancora nella lista
+    SlotList::iterator nextSlot(SlotList::iterator slotIt)
+    {
+        if(not (*slotIt)->isRemoved()) return std::next(slotIt);
+
+        slotIt = (*slotIt)->position();
+        while(slotIt != m_slots.end() and (*slotIt)->isRemoved()) slotIt = (*slotIt)->position();
+        return slotIt;
+    }
+
+
+
+    // ===============================
+    //
+    //  Metodi interni
+
+protected:
+    // Stacco una slot single shot durante l'emit: la tolgo dalla lista, dall'indice
+    // e dal receiver, senza eliminarla. Restituisce l'iteratore successivo
+    SlotList::iterator detachAt(SlotList::iterator slotIt);
+
+    // Elimino una slot già rimossa dalla lista (con SOBJECT_SEQLOCK_EMIT l'eliminazione è differita)
+    void destroySlot(_SlotCore* slot);
+
+    // Chiamata per ogni slot tolta dalla lista, i segnali derivati aggiornano i propri indici
+    virtual void slotRemoved(_SlotCore*) {}
+
+    // Un emit (del thread corrente o di un thread in attesa di un lock) sta scorrendo le slot
+#ifdef SOBJECT_THREAD_SAFE
+    bool iterated() const;
+#else
+    bool iterated() const
+    {
+        return m_iterations != 0;
+    }
+#endif
+
+private:
+    // Elimino le slot trattenute, nessun emit le sta più scorrendo
+    void releaseRetained();
+
+    // Rimuovo ed elimino la slot in posizione index dell'array dei receiver
+    void removeReceiverAt(std::size_t index);
+
+    // Tolgo la slot dall'array dei receiver, al suo posto va l'ultima voce
+    void unlistReceiver(_SlotCore* slot);
+
+    // Rimuovo la slot dall'indice hash (tra le slot uguali cerco quella con lo stesso indirizzo)
+    void unindexSlot(_SlotCore* slot);
+
+    // Rimuovo la slot dalla lista aggiornando l'inizio dei gruppi
+    SlotList::iterator eraseAt(SlotList::iterator slotIt);
+
+    // Inserisco la slot nella lista e nell'indice, senza invalidare il programma
+    SlotList::iterator insertSlot(_SlotCore* slot);
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Ricostruisco lo snapshot dalla lista: le slot rimosse escono dall'array e vengono ritirate
+    void publishSnapshot();
+
+    // Aggiungo in fondo allo snapshot una slot inserita in coda alla lista
+    void appendSnapshot(_SlotCore* slot);
+
+    // Segno una slot rimossa dalla lista: resta nello snapshot (saltata dagli emit tramite il suo bit
+    // nella bitmap) fino alla compattazione
+    void markRemoved(_SlotCore* slot);
+
+    // Scrivo array, bitmap, numero di slot e modalità di emit sotto seqlock
+    void storeSnapshot(_SlotCore** slots, std::atomic<std::uint64_t>* removed, std::size_t count);
+#endif
+
+    // Le slot sono cambiate: scarto il programma e invalido i flussi che attraversano il segnale
+    void invalidate();
+
+
+
+    // ===============================
+    //
+    //  Variabili
+
+protected:
+    SlotList m_slots;
+    _ReplayBase* m_replay = nullptr;
+
+    // Numero di slot single shot nella lista
+    std::size_t m_singleShots = 0;
+
+#ifdef SOBJECT_THREAD_SAFE
+    // Più emit concorrenti (con il lock condiviso) scrivono nel buffer di replay
+    _SpinLock m_replayLock;
+#endif
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Snapshot delle slot letto dagli emit senza lock. Gli elementi entro m_readCount non cambiano mai:
+    // le connect in coda scrivono oltre m_readCount, le altre modifiche pubblicano un nuovo array.
+    // Le slot rimosse restano nell'array con il proprio bit a 1 in m_readRemoved (un bit per elemento)
+    std::atomic<unsigned> m_sequence{0};
+    std::atomic<_SlotCore**> m_readSlots{nullptr};
+    std::atomic<std::atomic<std::uint64_t>*> m_readRemoved{nullptr};
+    std::atomic<std::size_t> m_readCount{0};
+    std::atomic<bool> m_readLocked{false};
+    std::size_t m_readCapacity = 0;
+
+    // Slot rimosse dalla lista ma ancora presenti nello snapshot
+    std::vector<_SlotCore*> m_removedSlots;
+#endif
+
+    // Programma di dispatch, valido solo se m_compiled; m_version cambia a ogni invalidazione
+    std::vector<Thunk> m_program;
+    bool m_compiled = false;
+    std::size_t m_version = 0;
+
+    // Numero progressivo assegnato alla prossima slot inserita
+    std::size_t m_nextSerial = 0;
+
+private:
+    // Segnale
+    const _MethodKey m_key;
+
+    // Prima slot di ogni gruppo (se il gruppo è vuoto, la prima di un gruppo successivo)
+    SlotList::iterator m_groupBegin[_GroupCount];
+
+    // Indice hash delle slot, usato per le connect unique
+    std::unordered_multiset<_SlotCore*, _SlotCore::SlotHash, _SlotCore::SlotEqual> m_slotIndex;
+    bool m_indexed = false;
+
+    // Receiver delle slot in un array contiguo (in ordine qualsiasi), scandito con confronti vettoriali
+    // dalla disconnect per receiver e da connectedWithObject; m_receiverSlots[i] è la slot di m_receivers[i]
+    std::vector<const SObject*> m_receivers;
+    std::vector<_SlotCore*> m_receiverSlots;
+
+    // Flusso compilato con radice nel segnale e flussi che lo attraversano
+    _Flow* m_flow = nullptr;
+    std::vector<_Flow*> m_dependentFlows;
+
+    // Slot rimosse mentre un emit scorreva il segnale: escono dalla lista ma restano in vita
+    // finché nessun emit lo scorre più
+    SlotList m_retainedSlots;
+
+    // Segnale tolto dall'emitter durante un emit, lo elimina l'ultimo emit che termina
+    bool m_orphaned = false;
+
+#ifdef SOBJECT_THREAD_SAFE
+    // Emit sul segnale di thread in attesa di un lock (segnati da _StripeWriteLock)
+    // ed emit ancora da terminare dopo la rimozione del segnale
+    std::atomic<unsigned> m_suspendedIterations{0};
+    std::atomic<unsigned> m_orphanIterations{0};
+
+    // Lo scheduler parallelo esegue le slot fuori dall'emit e stacca quelle single shot
+    friend class _Scheduler;
+    friend class _StripeWriteLock;
+#else
+    // Emit in corso sul segnale (annidati nelle slot)
+    std::size_t m_iterations = 0;
+#endif
+};
+
+
+
+// Emit che scorre le slot di un segnale: finché è attivo le slot rimosse restano in vita
+// e il segnale non viene eliminato, anche dalle slot stesse o da un altro thread
+class _IterationScope
+{
+public:
+    explicit _IterationScope(_SignalBase* signal) : m_signal(signal)
+    {
+        m_signal->beginIteration();
+    }
+
+    _IterationScope(const _IterationScope&) = delete;
+
+    ~_IterationScope()
+    {
+        m_signal->endIteration();
+    }
+
+private:
+    _SignalBase* const m_signal;
+};
+
+
+
+// =======================================
+//
+//               Signal
+//
+// =======================================
+
+template <typename Emitter, typename... Args>
+class _Signal : public _SignalBase
+{
+public:
+    // Anche se i costruttori sono pubblici non utilizzare le seguenti classi
+    _Signal() = delete;
+    _Signal(const _Signal&) = delete;
+    _Signal(void(Emitter::* const signal)(Args...)) : _SignalBase(_makeMethodKey(signal)) {};
+    _Signal(const _MethodKey& key) : _SignalBase(key) {};
+
+
+
+    // ===============================
+    //
+    //  Interfacce esterne
+
+public:
+    virtual _SignalBase* cloneEmpty() const override
+    {
+        return new _Signal(key());
+    }
+
+    void execAllSlots(Args&&... args)
+    {
+        // Le slot possono modificare la lista, o rimuovere il segnale, durante la scansione
+        _IterationScope scope(this);
+
+        // Le slot connesse da qui in poi vengono chiamate dagli emit successivi, come negli snapshot
+        const std::size_t serial = m_nextSerial;
+
+        // Solo l'ultima slot riceve i parametri inoltrati, le altre una copia di quelli per valore.
+        // Se l'ultima viene rimossa durante l'emit anche la slot chiamata per ultima riceve una copia
+        const _SlotCore* const last = m_slots.empty() ? nullptr : m_slots.back();
+
+        if(not m_compiled)
+        {
+            execSlotsFrom(m_slots.begin(), serial, last, args...);
+            return;
+        }
+
+        // Programma compilato: array contiguo di chiamate dirette
+        const std::size_t version = m_version;
+        for(std::size_t i = 0; i < m_program.size(); ++i)
+        {
+            const Thunk thunk = m_program[i];
+            const typename _SlotBase<Args...>::Call call = reinterpret_cast<typename _SlotBase<Args...>::Call>(thunk.call);
+
+            if(thunk.slot == last)
+            {
+                call(thunk.slot, std::forward<Args>(args)...);
+            }
+            else
+            {
+                call(thunk.slot, _SharedArg<Args>::pass(args)...);
+            }
+
+            // Se la slot ha modificato le connect continuo sulla lista, come l'emit non compilato
+            if(m_version != version)
+            {
+                execSlotsFrom(nextSlot(thunk.position), serial, last, args...);
+                return;
+            }
+        }
+    }
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Chiamo le slot di uno snapshot letto tramite readSnapshot (senza lock), 64 alla volta: le slot rimosse
+    // vengono saltate tramite la bitmap senza leggerle, un blocco di sole slot rimosse costa un confronto.
+    // count è letto all'inizio dell'emit: le connect effettuate durante l'emit non vengono chiamate
+    static void execSnapshot(_SlotCore* const* slots, const std::atomic<std::uint64_t>* removed, std::size_t count, Args&... args)
+    {
+        // Ultima slot viva: riceve i parametri inoltrati, le altre una copia di quelli per valore
+        std::size_t last = count;
+        for(std::size_t words = (count + 63) / 64; last == count and words != 0; --words)
+        {
+            const std::size_t first = (words - 1) * 64;
+            std::uint64_t live = ~removed[first / 64].load(std::memory_order_relaxed);
+            if(count - first < 64) live &= (std::uint64_t(1) << (count - first)) - 1;
+            if(live != 0) last = first + _highestBit(live);
+        }
+
+        for(std::size_t first = 0; first < count; first += 64)
+        {
+            const std::atomic<std::uint64_t>& word = removed[first / 64];
+            std::uint64_t live = ~word.load(std::memory_order_relaxed);
+            if(count - first < 64) live &= (std::uint64_t(1) << (count - first)) - 1;
+
+            while(live != 0)
+            {
+                const std::size_t index = first + _lowestBit(live);
+                _SlotBase<Args...>* slot = static_cast<_SlotBase<Args...>*>(slots[index]);
+                live &= live - 1;
+
+                if(index == last)
+                {
+                    slot->exec(std::forward<Args>(args)...);
+                }
+                else
+                {
+                    slot->exec(_SharedArg<Args>::pass(args)...);
+                }
+
+                // La slot può aver disconnesso le successive
+                live &= ~word.load(std::memory_order_relaxed);
+            }
+        }
+    }
+#endif
+
+    // Salvo i parametri per il replay (solo se il segnale ha il replay abilitato)
+    void record(const Args&... args)
+    {
+        if(m_replay == nullptr) return;
+
+#ifdef SOBJECT_THREAD_SAFE
+        _SpinGuard guard(m_replayLock);
+#endif
+
+        const void* argv[sizeof...(Args) + 1] = { &args..., nullptr };
+        m_replay->record(argv);
+    }
+
+
+
+    // ===============================
+    //
+    //  Metodi interni
+
+private:
+    void execSlotsFrom(SlotList::iterator slotIt, std::size_t serial, const _SlotCore* last, Args&... args)
+    {
+        while(slotIt != m_slots.end())
+        {
+            _SlotBase<Args...>* slot = static_cast<_SlotBase<Args...>*>(*slotIt);
+
+            // Slot connessa durante l'emit
+            if(slot->serial() >= serial)
+            {
+                ++slotIt;
+                continue;
+            }
+
+            // Le slot single shot vengono rimosse sul posto prima dell'esecuzione, così un emit
+            // annidato o la distruzione del receiver non le trovano più (restano in vita fino alla fine dell'emit)
+            if(slot->isSingleShot()) detachAt(slotIt);
+
+            execSlot(slot, last, args...);
+
+            slotIt = nextSlot(slotIt);
+        }
+    }
+
+    static void execSlot(_SlotBase<Args...>* slot, const _SlotCore* last, Args&... args)
+    {
+        if(slot == last)
+        {
+            slot->exec(std::forward<Args>(args)...);
+        }
+        else
+        {
+            slot->exec(_SharedArg<Args>::pass(args)...);
+        }
+    }
+};
+
+// Creazione di un segnale tipizzato a partire dalla sola chiave (usata dal rewire)
+typedef _SignalBase* (*_SignalFactory)(const _MethodKey& key);
+
+template <typename Emitter, typename... Args>
+_SignalBase* _makeSignal(const _MethodKey& key)
+{
+    return new _Signal<Emitter, Args...>(key);
+}
+
+
+
+// =======================================
+//
+//               Replay
+//
+// =======================================
+
+// Buffer circolare degli ultimi emit di un segnale: viene istanziato solo
+// per i segnali che abilitano il replay, l'emit lo usa tramite _ReplayBase
+template <typename... Args>
+class _Replay : public _ReplayBase
+{
+public:
+    _Replay(std::size_t depth) : m_depth(depth)
+    {
+        m_buffer.reserve(depth);
+    }
+
+
+
+    // ===============================
+    //
+    //  Override
+
+public:
+    // Salvo i parametri dell'emit nel buffer circolare
+    virtual void record(const void* const* argv) override
+    {
+        recordValue(argv, typename _MakeIndexSequence<sizeof...(Args)>::type());
+    }
+
+    // Consegno alla slot l'ultimo valore o tutto il buffer (dal più vecchio al più recente)
+    virtual bool replay(_SlotCore* slot, bool onlyLast) override
+    {
+        const std::size_t count = m_buffer.size();
+        if(count == 0) return false;
+
+        // Nel buffer non ancora pieno il più vecchio è in posizione 0, altrimenti in testa
+        const std::size_t first = (count < m_depth) ? 0 : m_head;
+        const std::size_t skip  = onlyLast ? count - 1 : 0;
+
+        for(std::size_t i = skip; i < count; ++i)
+        {
+            // Copio il valore in modo che la slot non possa modificare il buffer
+            _Value value = m_buffer[(first + i) % count];
+            replayValue(static_cast<_SlotBase<Args...>*>(slot), value, typename _MakeIndexSequence<sizeof...(Args)>::type());
+        }
+
+        return true;
+    }
+
+
+
+    // ===============================
+    //
+    //  Metodi interni
+
+private:
+    typedef std::tuple<typename std::decay<Args>::type...> _Value;
+
+    template <std::size_t... I>
+    void recordValue(const void* const* argv, _IndexSequence<I...>)
+    {
+        // Finché il buffer non è pieno aggiungo in coda, poi sovrascrivo il più vecchio
+        if(m_buffer.size() < m_depth)
+        {
+            m_buffer.emplace_back(*static_cast<const typename std::decay<Args>::type*>(argv[I])...);
+        }
+        else
+        {
+            m_buffer[m_head] = _Value(*static_cast<const typename std::decay<Args>::type*>(argv[I])...);
+        }
+
+        m_head = (m_head + 1) % m_depth;
+
+        (void)argv;
+    }
+
+    template <std::size_t... I>
+    static void replayValue(_SlotBase<Args...>* slot, _Value& value, _IndexSequence<I...>)
+    {
+        slot->exec(static_cast<Args&&>(std::get<I>(value))...);
+    }
+
+
+
+    // ===============================
+    //
+    //  Variabili
+
+private:
+    const std::size_t m_depth;
+    std::size_t m_head = 0;
+    std::vector<_Value> m_buffer;
+};
+
+// =======================================
+//
+//                Flow
+//
+// =======================================
+
+// Flusso compilato di un segnale: la prima emit registra in ordine i segnali emessi
+// a cascata dalle slot, le emit successive li prendono dal programma invece di
+// cercarli negli emitter e chiamano le slot tramite gli array di dispatch.
+// Ogni connect o disconnect su un segnale del flusso lo invalida,
+// e la emit successiva lo registra di nuovo
+class _Flow
+{
+public:
+    explicit _Flow(_SignalBase* root) : m_root(root) {};
+    _Flow(const _Flow&) = delete;
+    ~_Flow();
+
+    // Flusso in esecuzione nel thread corrente (nullptr se nessuno)
+    static _Flow* active();
+
+    // Segnale emesso da emitter durante l'esecuzione del flusso
+    _SignalBase* resolve(const SObject* emitter, const _MethodKey& key);
+
+    // Scarto il programma, verrà registrato di nuovo alla prossima emit
+    void invalidate();
+
+    void begin();
+    void end();
+
+private:
+    void depend(_SignalBase* signal);
+
+    // Un emit della cascata (signal è nullptr se l'emitter non aveva il segnale)
+    struct Step
+    {
+        const SObject* emitter;
+        _MethodKey key;
+        _SignalBase* signal;
+    };
+
+    enum State
+    {
+        Invalid,
+        Recording,
+        Valid
+    };
+
+    _SignalBase* const m_root;
+    std::vector<Step> m_steps;
+    std::vector<_SignalBase*> m_signals;
+    std::size_t m_cursor = 0;
+    State m_state = Invalid;
+};
+
+// Esecuzione di un flusso per la durata dello scope (anche in caso di eccezioni)
+class _FlowScope
+{
+public:
+    explicit _FlowScope(_Flow* flow) : m_flow(flow)
+    {
+        if(m_flow != nullptr) m_flow->begin();
+    }
+
+    _FlowScope(const _FlowScope&) = delete;
+
+    ~_FlowScope()
+    {
+        // Il flusso potrebbe essere stato eliminato da una slot
+        if(m_flow != nullptr and _Flow::active() == m_flow) m_flow->end();
+    }
+
+private:
+    _Flow* const m_flow;
+};
+
+
+
+// =======================================
+//
+//            ArraySignal
+//
+// =======================================
+
+// Segnale condiviso dagli elementi di un SObjectArray: le slot di tutti gli elementi stanno nella stessa
+// lista, e un indice per elemento permette a connect e disconnect di toccare solo le slot dell'elemento.
+// Per gli emit su un intervallo di elementi la lista viene trasformata in una tabella a colonne
+// (elemento, slot, chiamata) ordinata per elemento
+class _ArraySignalBase : public _SignalBase
+{
+protected:
+    _ArraySignalBase(const _MethodKey& key) : _SignalBase(key) {};
+
+public:
+    // Gli elementi sono salvati su 32 bit nelle colonne della tabella e negli indici:
+    // solo gli elementi fino a maxElement possono avere connect (controllato da SObjectArray)
+    static const std::size_t maxElement = 0xFFFFFFFFu;
+
+    // Aggiungo la slot di un elemento (element <= maxElement)
+    void addElementSlot(std::size_t element, _SlotCore* slot);
+
+    // Controllo se l'elemento ha già la slot (receiver, metodo)
+    bool containsElementSlot(std::size_t element, const _SlotCore* slot) const;
+
+    // Rimuovo le slot dell'elemento uguali a quella in input, o tutte le slot degli elementi da first in poi
+    void removeElementSlot(std::size_t element, const _SlotCore* slot);
+    void removeElementsFrom(std::size_t first);
+
+    // La tabella va ricostruita (le slot sono cambiate, anche per la distruzione di un receiver)
+    bool isStale() const
+    {
+        return not m_tableValid or m_tableVersion != m_version;
+    }
+
+    // Ricostruisco la tabella dalla lista delle slot (con il lock esclusivo)
+    void rebuild();
+
+protected:
+    // Chiamata che passa dal metodo virtuale exec, per le slot filtrate o accodate
+    virtual _ErasedCall execCall() const = 0;
+
+    // Tolgo la slot dall'indice del suo elemento (qualunque sia il motivo della rimozione)
+    virtual void slotRemoved(_SlotCore* slot) override;
+
+    // Tabella delle slot: colonne parallele, ordinate per elemento (a parità di elemento nell'ordine della lista)
+    std::vector<std::uint32_t> m_tableElements;
+    std::vector<_SlotCore*> m_tableSlots;
+    std::vector<_ErasedCall> m_tableCalls;
+
+private:
+    bool m_tableValid = false;
+    std::size_t m_tableVersion = 0;
+
+    // Slot di ogni elemento ed elemento di ogni slot, aggiornati a ogni connect e rimozione
+    std::unordered_map<std::uint32_t, std::vector<_SlotCore*>> m_elementSlots;
+    std::unordered_map<const _SlotCore*, std::uint32_t> m_elementOf;
+};
+
+template <typename Emitter, typename... Args>
+class _ArraySignal : public _ArraySignalBase
+{
+public:
+    _ArraySignal(void(Emitter::* const signal)(Args...)) : _ArraySignalBase(_makeMethodKey(signal)) {};
+    _ArraySignal(const _MethodKey& key) : _ArraySignalBase(key) {};
+
+    virtual _SignalBase* cloneEmpty() const override
+    {
+        return new _ArraySignal(key());
+    }
+
+    // Emetto il segnale degli elementi in [first, last) che hanno almeno una slot, con i parametri
+    // restituiti da argsFn(elemento, indice). Restituisce last, o l'elemento da cui riprendere
+    // se una slot ha modificato le connect dell'array (la tabella va ricostruita): called contiene
+    // le slot dell'elemento già chiamate, che alla ripresa vengono saltate. Le slot con un numero
+    // progressivo da serial in poi sono state connesse durante l'emit e non vengono chiamate
+    template <typename Objects, typename ArgsFn>
+    std::size_t execRange(Objects& objects, std::size_t first, std::size_t last, ArgsFn& argsFn, std::size_t serial, std::vector<_SlotCore*>& called)
+    {
+        typedef std::tuple<typename std::decay<Args>::type...> Values;
+
+        const std::size_t version = m_version;
+        const std::size_t count   = m_tableElements.size();
+        std::size_t i = std::lower_bound(m_tableElements.begin(), m_tableElements.end(), first) - m_tableElements.begin();
+
+        const auto skipped = [&called, serial](_SlotCore* slot)
+        {
+            return slot->serial() >= serial or std::find(called.begin(), called.end(), slot) != called.end();
+        };
+
+        while(i < count and m_tableElements[i] < last)
+        {
+            const std::size_t element = m_tableElements[i];
+            if(element != first) called.clear();
+
+            std::size_t end = i;
+            while(end < count and m_tableElements[end] == element) ++end;
+
+            // Elemento ripreso (o connesso durante l'emit) senza slot ancora da chiamare
+            if(std::all_of(m_tableSlots.begin() + i, m_tableSlots.begin() + end, skipped))
+            {
+                i = end;
+                continue;
+            }
+
+            // I parametri vengono calcolati una volta per elemento e passati a tutte le sue slot:
+            // l'ultima slot da chiamare riceve i valori inoltrati, le altre una copia di quelli per valore
+            Values values(argsFn(objects[element], element));
+
+            std::size_t lastCall = end - 1;
+            while(skipped(m_tableSlots[lastCall])) --lastCall;
+
+            for(; i < end; ++i)
+            {
+                _SlotCore* const slot = m_tableSlots[i];
+                if(skipped(slot)) continue;
+
+                called.push_back(slot);
+                callWith(m_tableCalls[i], slot, values, i == lastCall, typename _MakeIndexSequence<sizeof...(Args)>::type());
+                if(m_version != version) return element;
+            }
+        }
+
+        return last;
+    }
+
+protected:
+    virtual _ErasedCall execCall() const override
+    {
+        return reinterpret_cast<_ErasedCall>(&_ArraySignal::exec);
+    }
+
+private:
+    template <typename Values, std::size_t... I>
+    static void callWith(_ErasedCall call, _SlotCore* slot, Values& values, bool last, _IndexSequence<I...>)
+    {
+        (void)values;
+        const typename _SlotBase<Args...>::Call function = reinterpret_cast<typename _SlotBase<Args...>::Call>(call);
+
+        if(last)
+        {
+            function(slot, std::forward<Args>(std::get<I>(values))...);
+        }
+        else
+        {
+            function(slot, _SharedArg<Args>::pass(std::get<I>(values))...);
+        }
+    }
+
+    static void exec(_SlotCore* slot, Args&&... args)
+    {
+        static_cast<_SlotBase<Args...>*>(slot)->exec(std::forward<Args>(args)...);
+    }
+};
+
+
+
+// =======================================
+//
+//               Prefab
+//
+// =======================================
+
+// Connect interne di un gruppo di oggetti, catturate una volta e replicate su gruppi dello stesso tipo.
+// Le connect sono raggruppate per (emitter, segnale): ogni gruppo contiene le slot prototipo
+// (senza receiver) e l'indice del receiver di ognuna
+class _Prefab
+{
+public:
+    explicit _Prefab(std::initializer_list<SObject*> objects);
+    _Prefab(const _Prefab&) = delete;
+    ~_Prefab();
+
+    // Clono le connect sugli oggetti in input (stessi tipi e stesso ordine degli oggetti catturati)
+    void instantiate(std::initializer_list<SObject*> objects) const;
+
+    std::size_t connectionCount() const
+    {
+        return m_connections;
+    }
+
+private:
+    struct Group
+    {
+        std::size_t emitter;
+        _SignalBase* prototype;
+        std::vector<_SlotCore*> slots;
+        std::vector<std::size_t> receivers;
+    };
+
+    std::vector<Group> m_groups;
+    std::size_t m_objects = 0;
+    std::size_t m_connections = 0;
+};
+
+
+
+#ifdef SOBJECT_THREAD_SAFE
+
+// =======================================
+//
+//              Scheduler
+//
+// =======================================
+
+class _Scheduler;
+
+// Emit accodato in SSlotScheduler: i parametri restano qui finché tutte le slot non sono state eseguite
+class _ScheduledEmit
+{
+public:
+    virtual ~_ScheduledEmit() {};
+
+    // Salvo i parametri nel buffer di replay del segnale (con il lock condiviso dell'emitter)
+    virtual void record(_SignalBase* signal) = 0;
+
+    // Chiamo una slot del segnale, anche da più thread insieme
+    virtual void call(_SlotCore* slot) = 0;
+};
+
+template <typename Emitter, typename... Args>
+class _ScheduledSignal : public _ScheduledEmit
+{
+public:
+    template <typename... Values>
+    explicit _ScheduledSignal(Values&&... values) : m_values(std::forward<Values>(values)...) {}
+
+    virtual void record(_SignalBase* signal) override
+    {
+        recordValues(static_cast<_Signal<Emitter, Args...>*>(signal), typename _MakeIndexSequence<sizeof...(Args)>::type());
+    }
+
+    virtual void call(_SlotCore* slot) override
+    {
+        callWith(static_cast<_SlotBase<Args...>*>(slot), typename _MakeIndexSequence<sizeof...(Args)>::type());
+    }
+
+private:
+    template <std::size_t... I>
+    void recordValues(_Signal<Emitter, Args...>* signal, _IndexSequence<I...>)
+    {
+        signal->record(std::get<I>(m_values)...);
+    }
+
+    template <std::size_t... I>
+    void callWith(_SlotBase<Args...>* slot, _IndexSequence<I...>)
+    {
+        slot->exec(_SharedArg<Args>::pass(std::get<I>(m_values))...);
+    }
+
+    std::tuple<typename std::decay<Args>::type...> m_values;
+};
+
+#endif // SOBJECT_THREAD_SAFE
+
+
+
+// =======================================
+//
+//            StaticGraph
+//
+// =======================================
+
+template <typename T>
+struct _Void
+{
+    typedef void type;
+};
+
+// Base comune dei grafi statici, usata da SObject per puntare al proprio grafo
+class _StaticGraphBase
+{
+public:
+    // Chiamata dall'oggetto legato quando viene distrutto prima del grafo
+    virtual void unbind(SObject* object) = 0;
+
+    // Chiamata dall'oggetto legato quando viene spostato: il grafo punta al nuovo indirizzo
+    virtual void rebind(SObject* from, SObject* to) = 0;
+
+protected:
+    _StaticGraphBase() = default;
+    _StaticGraphBase(const _StaticGraphBase&) = delete;
+    virtual ~_StaticGraphBase() = default;
+};
+
+// Classe e parametri di un puntatore a metodo
+template <typename Method>
+struct _MethodTraits;
+
+template <typename Class, typename... Args>
+struct _MethodTraits<void(Class::*)(Args...)>
+{
+    typedef Class ClassType;
+    typedef std::tuple<Args...> ArgsType;
+};
+
+// Dispatch verso il grafo statico: per le classi che non dichiarano
+// SStaticWiring non genera alcun codice
+template <typename Emitter, typename = void>
+struct _StaticDispatch
+{
+    template <typename SignalT, typename... Args>
+    static void emit(_StaticGraphBase*, SignalT, Args&...) {}
+};
+
+template <typename Emitter>
+struct _StaticDispatch<Emitter, typename _Void<typename Emitter::SStaticWiring>::type>
+{
+    template <typename SignalT, typename... Args>
+    static void emit(_StaticGraphBase* graph, SignalT signalM, Args&... args)
+    {
+        typedef typename Emitter::SStaticWiring::Graph Graph;
+        if(graph != nullptr) static_cast<Graph*>(graph)->dispatch(signalM, args...);
+    }
+};
+
+// Controllo se un oggetto è legato a un grafo del tipo Graph
+template <typename Object, typename Graph, typename = void>
+struct _IsWiredTo : std::false_type {};
+
+template <typename Object, typename Graph>
+struct _IsWiredTo<Object, Graph, typename _Void<typename Object::SStaticWiring>::type>
+    : std::is_same<typename Object::SStaticWiring::Graph, Graph> {};
+
+// Cerco tra gli oggetti il primo convertibile in T*
+template <typename T>
+T* _findObject()
+{
+    return nullptr;
+}
+
+template <typename T, typename First, typename... Rest>
+T* _findObject(First* first, Rest*... rest);
+
+template <typename T, typename First, typename... Rest>
+T* _findObject(std::true_type, First* first, Rest*...)
+{
+    return first;
+}
+
+template <typename T, typename First, typename... Rest>
+T* _findObject(std::false_type, First*, Rest*... rest)
+{
+    return _findObject<T>(rest...);
+}
+
+template <typename T, typename First, typename... Rest>
+T* _findObject(First* first, Rest*... rest)
+{
+    return _findObject<T, First, Rest...>(std::is_convertible<First*, T*>(), first, rest...);
+}
+
+// Controllo a tempo di compilazione che tra gli oggetti ci sia un T
+template <typename T, typename... Objects>
+struct _HasObject : std::false_type {};
+
+template <typename T, typename First, typename... Rest>
+struct _HasObject<T, First, Rest...>
+    : std::integral_constant<bool, std::is_convertible<First*, T*>::value or _HasObject<T, Rest...>::value> {};
+
+template <bool... Values>
+struct _AllTrue : std::true_type {};
+
+template <bool First, bool... Rest>
+struct _AllTrue<First, Rest...> : std::integral_constant<bool, First and _AllTrue<Rest...>::value> {};
+
+} // namespace _sobject
+
+
+
+
+
+
+
+
+
+/* ===========================================================================
+ *
+ *    Di seguito sono presenti le classi e i metodi da utilizzare.
+ *
+ * ===========================================================================
+ */
+
+template <typename... Conns>
+class SStaticGraph;
+
+template <typename T>
+class SObjectArray;
+
+// Opzioni di una connect, combinabili tra loro:
+//     SConnectOptions(SQueuedConnection).module(plugin).rateLimit({100, 10}).sampling({8, false})
+// Un SModuleToken, un SRateLimit, un SSampling o un SAccess da soli vengono convertiti implicitamente
+class SConnectOptions
+{
+public:
+    SConnectOptions(SConnectionType type = SDefaultConnection) : m_type(type) {};
+    SConnectOptions(SModuleToken& module) { this->module(module); };
+    SConnectOptions(const SRateLimit& limit) { rateLimit(limit); };
+    SConnectOptions(const SSampling& sampling) { this->sampling(sampling); };
+#ifdef SOBJECT_THREAD_SAFE
+    SConnectOptions(const SAccess& access) { this->access(access); };
+#endif
+
+    // Tipo della connect (sostituisce quello precedente)
+    SConnectOptions& type(SConnectionType type)
+    {
+        m_type = type;
+        return *this;
+    }
+
+    // Modulo a cui appartiene la connect: viene rimossa da disconnectModule o dalla distruzione del token
+    SConnectOptions& module(SModuleToken& module)
+    {
+        m_module = &module;
+        return *this;
+    }
+
+    // Limite di chiamate al secondo: gli emit oltre il limite non raggiungono la slot
+    SConnectOptions& rateLimit(const SRateLimit& limit)
+    {
+        m_limit = limit;
+        m_hasLimit = true;
+        return *this;
+    }
+
+    // Campionamento (es. receiver di telemetria su segnali frequenti): gli emit esclusi costano un incremento e un confronto
+    SConnectOptions& sampling(const SSampling& sampling)
+    {
+        m_sampling = sampling;
+        m_hasSampling = true;
+        return *this;
+    }
+
+#ifdef SOBJECT_THREAD_SAFE
+    // Risorse lette e scritte dalla slot: SSlotScheduler la esegue in parallelo
+    // alle slot che non scrivono le sue risorse e non leggono quelle che scrive
+    SConnectOptions& access(const SAccess& access)
+    {
+        m_access = access;
+        m_hasAccess = true;
+        return *this;
+    }
+#endif
+
+    SConnectionType connectionType() const { return m_type; }
+    SModuleToken* moduleToken() const { return m_module; }
+    const SRateLimit* rateLimitFilter() const { return m_hasLimit ? &m_limit : nullptr; }
+    const SSampling* samplingFilter() const { return m_hasSampling ? &m_sampling : nullptr; }
+#ifdef SOBJECT_THREAD_SAFE
+    const SAccess* accessFilter() const { return m_hasAccess ? &m_access : nullptr; }
+#endif
+
+private:
+    SConnectionType m_type = SDefaultConnection;
+    SModuleToken* m_module = nullptr;
+    SRateLimit m_limit     = {};
+    SSampling m_sampling   = {};
+    bool m_hasLimit        = false;
+    bool m_hasSampling     = false;
+#ifdef SOBJECT_THREAD_SAFE
+    SAccess m_access;
+    bool m_hasAccess       = false;
+#endif
+};
+
+// Dichiarazione anticipata della connect per definire il parametro di default
+template<typename Emitter, typename Receiver, typename... Args>
+bool connect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...), SConnectionType type = SDefaultConnection);
+
+template<typename Emitter, typename Receiver, typename... Args>
+bool connect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...), const SConnectOptions& options);
+
+namespace _sobject
+{
+// Implementazione comune delle connect
+template<typename Emitter, typename Receiver, typename... Args>
+bool _connect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...), const SConnectOptions& options);
+}
+
+
+
+// =======================================
+//
+//               SObject
+//
+// =======================================
+
+class SObject
+{
+public:
+    SObject(){};
+
+    // La copia duplicherebbe le connect (e le eliminerebbe due volte), l'oggetto è solo spostabile
+    SObject(const SObject&) = delete;
+    SObject& operator=(const SObject&) = delete;
+
+    // Lo spostamento trasferisce al nuovo indirizzo tutte le connect (come emitter e come receiver),
+    // il grafo statico e lo shard dell'event loop in O(numero di connect), senza ricrearle.
+    // L'oggetto spostato resta vuoto e valido. I task accodati verso di lui vengono scartati.
+    // Va spostato il tipo derivato completo, e nessun emit deve raggiungere i due oggetti durante lo spostamento
+    SObject(SObject&& other);
+    SObject& operator=(SObject&& other);
+
+    virtual ~SObject();
+
+
+
+    // ===============================
+    //
+    //  Emit
+
+protected:
+    template <typename Emitter, typename... Args>
+    void emitSignal(void(Emitter::* const signalM)(Args...), Args... args) const
+    {
+        // Connect statiche: chiamate dirette alle slot, senza passare da m_signalsList
+        _sobject::_StaticDispatch<Emitter>::emit(m_staticGraph, signalM, args...);
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+        // Emit senza lock sugli snapshot, i segnali con slot single shot o replay proseguono con il lock
+        _sobject::_EpochGuard epochGuard;
+        if(emitSnapshot(signalM, args...)) return;
+#endif
+
+        // Le slot vengono chiamate con il lock condiviso dell'emitter (solo con SOBJECT_THREAD_SAFE)
+        _sobject::_StripeReadLock readLock(this);
+
+        // Cerco il segnale tramite la sua chiave (nessuna allocazione),
+        // durante un flusso compilato il segnale è già risolto nel programma
+        const _sobject::_MethodKey key = _sobject::_makeMethodKey(signalM);
+        _sobject::_Flow* flow = _sobject::_Flow::active();
+        _sobject::_SignalBase* signal = flow != nullptr ? flow->resolve(this, key) : findSignal(key);
+        if(signal == nullptr) return;
+
+        // Le slot single shot vengono staccate durante l'emit, serve il lock esclusivo.
+        // Mentre il lock passa da condiviso a esclusivo il segnale può essere rimosso, lo cerco di nuovo
+        _sobject::_StripeWriteLock writeLock(signal->hasSingleShots() ? _sobject::_stripeMask(this) : 0);
+        if(writeLock.acquired() and (signal = findSignal(key)) == nullptr) return;
+
+        // La chiave contiene il tipo del segnale, il cast è sicuro
+        _sobject::_Signal<Emitter, Args...>* slotContainer = static_cast<_sobject::_Signal<Emitter, Args...>*>(signal);
+
+        // Salvo i parametri per il replay prima di chiamare le slot
+        slotContainer->record(args...);
+
+        // Se il segnale è la radice di un flusso compilato lo eseguo
+        _sobject::_FlowScope flowScope(flow == nullptr ? signal->flow() : nullptr);
+
+        // Chiamo tutte le slot
+        slotContainer->execAllSlots(std::forward<Args>(args)...);
+    }
+
+    // Chiamata quando una connect verso l'oggetto viene rimossa senza essere eseguita: disconnect o
+    // distruzione dell'emitter (le slot single shot staccate per l'emit non la chiamano).
+    // Viene chiamata con il lock dell'emitter preso, mai durante la distruzione dell'oggetto stesso
+    virtual void connectionRemoved() {}
+
+    // Abilito il replay del segnale: vengono mantenuti gli ultimi depth emit
+    // e consegnati alle connect effettuate con SReplayLastConnection o SReplayAllConnection
+    template <typename Emitter, typename... Args>
+    void setSignalReplay(void(Emitter::* const signalM)(Args...), std::size_t depth = 1)
+    {
+        _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(this));
+
+        // Cerco il segnale, se non esiste lo registro senza slot
+        signalFor(signalM)->setReplay(depth != 0 ? new _sobject::_Replay<Args...>(depth) : nullptr);
+    }
+
+    // Abilito la compilazione del flusso del segnale: la cascata di emit generata dalle slot
+    // viene registrata alla prima emit e poi eseguita come programma di dispatch piatto.
+    // Il programma è condiviso tra gli emit, con SOBJECT_THREAD_SAFE la chiamata non ha effetto
+    template <typename Emitter, typename... Args>
+    void setSignalFlow(void(Emitter::* const signalM)(Args...), bool compiled = true)
+    {
+#ifndef SOBJECT_THREAD_SAFE
+        _sobject::_SignalBase* signal = signalFor(signalM);
+        signal->setFlow(compiled ? new _sobject::_Flow(signal) : nullptr);
+#else
+        (void)signalM;
+        (void)compiled;
+#endif
+    }
+
+
+
+    // ===============================
+    //
+    //  Metodi esterni
+
+public:
+    bool connectedWithObject(SObject* receiver) const;
+    std::list<SObject*> getAllReceivers(_sobject::_SignalBase* signalIn = nullptr) const;
+
+
+
+    // ===============================
+    //
+    //  Metodi interni
+
+private:
+    // Cerco il segnale con la chiave in input
+    _sobject::_SignalBase* findSignal(const _sobject::_MethodKey& key) const;
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Pubblico la tabella dei segnali (chiamato con il lock esclusivo dopo ogni modifica di m_signalsList)
+    void publishSignals();
+
+    template <typename Emitter, typename... Args>
+    bool emitSnapshot(void(Emitter::* const signalM)(Args...), Args&... args) const
+    {
+        const _sobject::_SignalTable* table = m_signalTable.load(std::memory_order_acquire);
+        if(table == nullptr) return true;
+
+        const _sobject::_MethodKey key = _sobject::_makeMethodKey(signalM);
+        for(_sobject::_SignalBase* signal : table->signals)
+        {
+            if(not signal->compareByKey(key)) continue;
+
+            _sobject::_SlotCore* const* slots = nullptr;
+            const std::atomic<std::uint64_t>* removed = nullptr;
+            std::size_t count = 0;
+            if(not signal->readSnapshot(slots, removed, count)) return false;
+
+            _sobject::_Signal<Emitter, Args...>::execSnapshot(slots, removed, count, args...);
+            return true;
+        }
+
+        return true;
+    }
+#endif
+
+    // Cerco il segnale tipizzato, se non esiste lo creo
+    template <typename Emitter, typename... Args>
+    _sobject::_Signal<Emitter, Args...>* signalFor(void(Emitter::* const signalM)(Args...))
+    {
+        _sobject::_SignalBase* signal = findSignal(_sobject::_makeMethodKey(signalM));
+        if(signal != nullptr) return static_cast<_sobject::_Signal<Emitter, Args...>*>(signal);
+
+        _sobject::_Signal<Emitter, Args...>* newSignal = new _sobject::_Signal<Emitter, Args...>(signalM);
+        m_signalsList.push_back(newSignal);
+#ifdef SOBJECT_SEQLOCK_EMIT
+        publishSignals();
+#endif
+        return newSignal;
+    }
+
+    // Rimuovo il segnale (se ha il replay o il flusso abilitato rimuovo solo le slot per mantenere lo stato)
+    void removeSignal(const _sobject::_MethodKey& key);
+
+    void removeAllSignal(bool keepPersistent = true);
+
+    // Elimino un segnale già rimosso da m_signalsList (se un emit lo sta scorrendo lo elimina l'ultimo emit)
+    void destroySignal(_sobject::_SignalBase* signal);
+
+    // Rimuovo tutte le connect dell'oggetto, come emitter e come receiver (distruttore e assegnamento)
+    void releaseConnections();
+
+    // Prendo le connect di other bloccando gli stripe coinvolti, poi le sposto
+    void takeConnections(SObject& other);
+    void moveConnections(SObject& other);
+
+#ifdef SOBJECT_THREAD_SAFE
+    // Stripe degli emitter che hanno una connect verso l'oggetto (0 se nessuna)
+    std::uint64_t emitterMask();
+#endif
+
+
+
+    // ===============================
+    //
+    //  Strutture interne
+
+private:
+    std::list<_sobject::_SignalBase*> m_signalsList;
+
+    // Una voce per ogni connect in cui l'oggetto è receiver (contiene la slot, da cui si ricava l'emitter)
+    std::list<_sobject::_SlotCore*> m_slotToSignalObjectList;
+
+    // Grafo statico a cui è legato l'oggetto
+    _sobject::_StaticGraphBase* m_staticGraph = nullptr;
+
+#ifdef SOBJECT_THREAD_SAFE
+    // La lista del receiver viene modificata dalle connect di emitter diversi
+    _sobject::_SpinLock m_receiverLock;
+
+    // Shard dell'event loop a cui è assegnato l'oggetto e stato letto dai task accodati.
+    // Lo stato si legge e si scrive solo con std::atomic_load/atomic_store: gli emit lo copiano senza lock
+    std::atomic<_sobject::_EventShard*> m_shard{nullptr};
+    std::shared_ptr<_sobject::_LoopState> m_loopState;
+#endif
+
+#ifdef SOBJECT_SEQLOCK_EMIT
+    // Copia di m_signalsList letta dagli emit senza lock
+    std::atomic<const _sobject::_SignalTable*> m_signalTable{nullptr};
+#endif
+
+
+
+    // ===============================
+    //
+    //  Friend
+
+    friend class _sobject::_SlotCore;
+    friend class _sobject::_Flow;
+    friend class _sobject::_Prefab;
+    friend class SWiring;
+
+    template <typename... Conns>
+    friend class SStaticGraph;
+
+    template <typename T>
+    friend class SObjectArray;
+
+    template<typename E, typename R, typename... Args>
+    friend bool _sobject::_connect(SObject* emitter, void(E::*signalM)(Args...), R* receiver, void(R::*slotM)(Args...), const SConnectOptions& options);
+
+    template<typename Emitter, typename Receiver, typename... Args>
+    friend std::uint64_t droppedCount(const SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...));
+
+    template<typename Emitter, typename Receiver, typename... Args>
+    friend void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...));
+
+    template<typename Emitter, typename Receiver, typename... Args>
+    friend void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver);
+
+    template<typename Emitter, typename... Args>
+    friend void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...));
+
+    friend void disconnect(SObject* emitter);
+
+#ifdef SOBJECT_THREAD_SAFE
+    friend class SEventLoopPool;
+    friend class _sobject::_EventShard;
+    friend _sobject::_EventShard* _sobject::_queuedShard(const SObject* receiver, bool idle);
+    friend std::shared_ptr<const _sobject::_LoopState> _sobject::_loopState(const SObject* receiver);
+    friend class _sobject::_Scheduler;
+#endif
+};
+
+
+
+
+
+
+
+
+
+// =======================================
+//
+//               Connect
+//
+// =======================================
+
+// Restituisce false se la connect non è stata effettuata (es. slot già presente con SUniqueConnection)
+template<typename Emitter, typename Receiver, typename... Args>
+bool connect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...), SConnectionType type)
+{
+    return _sobject::_connect(emitter, signalM, receiver, slotM, SConnectOptions(type));
+}
+
+// Connect con modulo, limite, campionamento e risorse combinati in un SConnectOptions
+template<typename Emitter, typename Receiver, typename... Args>
+bool connect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...), const SConnectOptions& options)
+{
+    return _sobject::_connect(emitter, signalM, receiver, slotM, options);
+}
+
+// Numero di emit scartati dal limite delle connect tra il segnale e la slot
+template<typename Emitter, typename Receiver, typename... Args>
+std::uint64_t droppedCount(const SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...))
+{
+    _sobject::_StripeReadLock readLock(emitter);
+
+    const _sobject::_SignalBase* signal = emitter->findSignal(_sobject::_makeMethodKey(signalM));
+    if(signal == nullptr) return 0;
+
+    const _sobject::_Slot<Receiver, Args...> slot(receiver, slotM);
+    return signal->droppedCount(&slot);
+}
+
+template<typename Emitter, typename Receiver, typename... Args>
+bool _sobject::_connect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...), const SConnectOptions& options)
+{
+    const SConnectionType type = options.connectionType();
+    const SRateLimit* limit    = options.rateLimitFilter();
+    const SSampling* sampling  = options.samplingFilter();
+
+    // Un limite non valido non lascerebbe passare nessuna chiamata (o quasi): rifiuto la connect
+    if(limit != nullptr and not _RateLimiter::isValid(*limit)) return false;
+
+    // Creo l'oggetto per identificare la slot
+    _sobject::_Slot<Receiver, Args...>* slot = new _sobject::_Slot<Receiver, Args...>(receiver, slotM, type);
+    if(limit != nullptr)    slot->setRateLimit(*limit);
+    if(sampling != nullptr) slot->setSampling(*sampling);
+#ifdef SOBJECT_THREAD_SAFE
+    if(options.accessFilter() != nullptr) slot->setAccess(*options.accessFilter());
+#endif
+
+    _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(emitter));
+
+    // Cerco il segnale nell'emitter, se è la prima connect lo creo
+    _sobject::_Signal<Emitter, Args...>* signal = emitter->signalFor(signalM);
+
+    // Con SUniqueConnection rifiuto la slot se è già connessa
+    if((type & SUniqueConnection) and signal->containsSlot(slot))
+    {
+        delete slot;
+        return false;
+    }
+
+    // Salvo la nuova slot e registro l'emitter nel ricevitore (e la slot nel modulo)
+    signal->addSlot(slot);
+    slot->link(emitter, options.moduleToken());
+
+    // Consegno alla nuova slot i valori già emessi (solo se il segnale ha il replay abilitato)
+    if(type & (SReplayLastConnection | SReplayAllConnection))
+    {
+        // La slot e il segnale restano validi anche se la slot li rimuove (i lock vengono sospesi)
+        _sobject::_IterationScope scope(signal);
+
+        // Una slot single shot riceve solo l'ultimo valore e viene subito disconnessa
+        if(signal->replay(slot, slot->isSingleShot() or not (type & SReplayAllConnection)) and slot->isSingleShot() and not slot->isRemoved())
+        {
+            signal->eraseSlot(slot);
+        }
+    }
+
+    return true;
+}
+
+
+
+// =======================================
+//
+//             Disconnect
+//
+// =======================================
+
+template<typename Emitter, typename Receiver, typename... Args>
+void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...))
+{
+    _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(emitter));
+
+    // Trovo il segnale nell'emitter
+    _sobject::_SignalBase* signal = emitter->findSignal(_sobject::_makeMethodKey(signalM));
+    if(signal == nullptr) return;
+
+    // Rimuovo le slot uguali a quella in input (ogni slot eliminata rimuove la propria voce dal receiver)
+    const _sobject::_Slot<Receiver, Args...> slot(receiver, slotM);
+    signal->removeSlot(&slot);
+}
+
+template<typename Emitter, typename Receiver, typename... Args>
+void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver)
+{
+    _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(emitter));
+
+    // Trovo il segnale nell'emitter
+    _sobject::_SignalBase* signal = emitter->findSignal(_sobject::_makeMethodKey(signalM));
+    if(signal == nullptr) return;
+
+    // Rimuovo slot (ogni slot eliminata rimuove la propria voce dal receiver)
+    signal->removeSlotByReceiver(receiver);
+}
+
+template<typename Emitter, typename... Args>
+void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...))
+{
+    _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(emitter));
+    emitter->removeSignal(_sobject::_makeMethodKey(signalM));
+}
+
+void disconnect(SObject* emitter);
+
+// Rimuovo tutte le connect del modulo scorrendo solo le sue slot (da chiamare prima di dlclose).
+// Al ritorno nessun emit di un altro thread sta eseguendo una slot del modulo (se non è chiamata da una slot)
+void disconnectModule(SModuleToken& module);
+
+
+
+// =======================================
+//
+//               Rewire
+//
+// =======================================
+
+// Numero di connect aggiunte e rimosse da rewire
+struct SRewireResult
+{
+    std::size_t added;
+    std::size_t removed;
+};
+
+// Insieme di connect desiderato. rewire lo confronta con le connect attuali degli emitter che contiene
+// e applica solo le differenze: le connect uguali (stesso segnale, receiver, slot e tipo) restano
+// intatte, quelle mancanti vengono aggiunte e quelle non più presenti rimosse.
+// Gli emitter senza connect desiderate vanno aggiunti con include, altrimenti non vengono toccati.
+// L'insieme può essere applicato più volte, i receiver devono essere vivi fino all'ultima applicazione
+class SWiring
+{
+public:
+    SWiring() {};
+    SWiring(const SWiring&) = delete;
+    SWiring& operator=(const SWiring&) = delete;
+    ~SWiring();
+
+    template<typename Emitter, typename Receiver, typename... Args>
+    void connect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...), SConnectionType type = SDefaultConnection)
+    {
+        signalFor(emitter, _sobject::_makeMethodKey(signalM), &_sobject::_makeSignal<Emitter, Args...>)
+            .slots.push_back(new _sobject::_Slot<Receiver, Args...>(receiver, slotM, type));
+    }
+
+    // Emitter gestito dall'insieme anche senza connect desiderate (rewire rimuove tutte le sue connect)
+    void include(SObject* emitter);
+
+    void clear();
+
+private:
+    struct Signal
+    {
+        _sobject::_MethodKey key;
+        _sobject::_SignalFactory factory;
+        std::vector<_sobject::_SlotCore*> slots;
+    };
+
+    struct Emitter
+    {
+        SObject* object;
+        std::vector<Signal> signals;
+    };
+
+    Emitter& emitterFor(SObject* emitter);
+    Signal& signalFor(SObject* emitter, const _sobject::_MethodKey& key, _sobject::_SignalFactory factory);
+
+    // Confronto e modifica delle connect di un emitter
+    void apply(const Emitter& emitter, SRewireResult& result) const;
+
+    std::vector<Emitter> m_emitters;
+    std::unordered_map<const SObject*, std::size_t> m_index;
+
+    friend SRewireResult rewire(const SWiring& wiring);
+};
+
+// Applico l'insieme di connect, un emitter alla volta: le nuove slot vengono allocate prima di prendere
+// il lock esclusivo dell'emitter, che viene tenuto solo per il confronto e l'inserimento/rimozione
+SRewireResult rewire(const SWiring& wiring);
+
+
+
+// =======================================
+//
+//             ModuleToken
+//
+// =======================================
+
+// Token di un modulo (es. un plugin caricato con dlopen). Le connect effettuate con il token
+// sono indicizzate nel token stesso, quindi vengono rimosse senza scorrere gli SObject.
+// Il distruttore rimuove le connect rimaste
+class SModuleToken
+{
+public:
+    SModuleToken(){};
+    SModuleToken(const SModuleToken&) = delete;
+    SModuleToken& operator=(const SModuleToken&) = delete;
+    ~SModuleToken();
+
+    // Numero di connect del modulo ancora attive
+    std::size_t connectionCount() const
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        _sobject::_SpinGuard guard(m_lock);
+#endif
+        return m_slots.size();
+    }
+
+private:
+    std::list<_sobject::_SlotCore*> m_slots;
+
+#ifdef SOBJECT_THREAD_SAFE
+    mutable _sobject::_SpinLock m_lock;
+#endif
+
+    friend class _sobject::_SlotCore;
+    friend void disconnectModule(SModuleToken& module);
+};
+
+
+
+// =======================================
+//
+//              Causality
+//
+// =======================================
+
+// Identificativo di causalità del thread corrente: gli emit effettuati dentro le slot lo ereditano,
+// e le slot accodate (SQueuedConnection, SIdleConnection) lo ritrovano nel thread del loop.
+// Gli span di tracing possono leggerlo per collegarsi all'evento che li ha causati
+inline std::uint64_t currentCausality()
+{
+    return _sobject::_causality();
+}
+
+// Nuovo identificativo, unico nel processo (mai 0)
+std::uint64_t newCausality();
+
+// Imposta la causalità del thread per la durata dello scope, poi ripristina la precedente
+class SCausalityScope
+{
+public:
+    explicit SCausalityScope(std::uint64_t id) : m_previous(_sobject::_causality())
+    {
+        _sobject::_causality() = id;
+    }
+
+    SCausalityScope(const SCausalityScope&) = delete;
+    SCausalityScope& operator=(const SCausalityScope&) = delete;
+
+    ~SCausalityScope()
+    {
+        _sobject::_causality() = m_previous;
+    }
+
+private:
+    const std::uint64_t m_previous;
+};
+
+
+
+#ifdef SOBJECT_THREAD_SAFE
+
+// =======================================
+//
+//            EventLoopPool
+//
+// =======================================
+
+// Un event loop per core, ognuno su un thread fissato al proprio core (pthread_setaffinity_np su Linux).
+// Gli oggetti vengono assegnati a uno shard per hash dell'indirizzo o esplicitamente; le slot connesse
+// con SQueuedConnection vengono eseguite nel loop dello shard del receiver, inserendo la chiamata
+// direttamente nella sua coda MPSC. Un emit dal thread dello shard stesso chiama la slot subito.
+// Le slot connesse con SIdleConnection passano sempre da una seconda coda, eseguita solo quando
+// la prima è vuota e per al più il budget idle di ogni iterazione.
+// Un oggetto assegnato va distrutto nel thread del suo loop, oppure dopo stop() (chiamata anche dal
+// distruttore del pool), che chiude i loop e rilascia gli oggetti ancora assegnati
+
+// Spostamento di un oggetto deciso dal ripartizionamento
+struct SPlacementMove
+{
+    SObject* object;
+    std::size_t from;
+    std::size_t to;
+};
+
+// Esito dell'ultimo ripartizionamento: traffico campionato tra gli oggetti del pool (chiamate delle
+// connect accodate dall'ultimo campionamento), quota tra shard diversi prima e dopo, oggetti per shard
+struct SPlacementReport
+{
+    std::uint64_t traffic            = 0;
+    std::uint64_t crossTrafficBefore = 0;
+    std::uint64_t crossTrafficAfter  = 0;
+    std::vector<std::size_t> objects;
+    std::vector<SPlacementMove> moves;
+};
+
+class SEventLoopPool
+{
+public:
+    // Con shards == 0 uso un loop per ogni core disponibile
+    explicit SEventLoopPool(std::size_t shards = 0, bool pinThreads = true);
+    SEventLoopPool(const SEventLoopPool&) = delete;
+    SEventLoopPool& operator=(const SEventLoopPool&) = delete;
+
+    // Chiama stop()
+    ~SEventLoopPool();
+
+    // Esegue i task già accodati, termina i thread e rilascia gli oggetti ancora assegnati, che da qui
+    // in poi possono essere distrutti in qualsiasi thread (anche dopo il pool). I task accodati dopo la
+    // chiusura vengono scartati, assign e migrate non hanno più effetto. Non va chiamata mentre altri
+    // thread emettono verso gli oggetti del pool; dal thread di un loop non ha effetto
+    void stop();
+
+    std::size_t size() const
+    {
+        return m_shards.size();
+    }
+
+    // Assegno l'oggetto a uno shard tramite l'hash del suo indirizzo, restituisce l'indice dello shard
+    std::size_t assign(SObject* object);
+
+    // Assegno l'oggetto a uno shard scelto
+    void assign(SObject* object, std::size_t shard);
+
+    // Tolgo l'affinità: le slot accodate verso l'oggetto tornano a essere chiamate subito
+    void release(SObject* object);
+
+    // Sposto l'oggetto in un altro shard (come moveToThread): il cambio avviene nel loop dello shard
+    // corrente tra due task, quelli rimasti nella sua coda vengono inoltrati al nuovo shard
+    void migrate(SObject* object, std::size_t shard);
+
+    // Campiono il traffico delle connect accodate tra gli oggetti del pool (nel loop di ogni shard) e li
+    // ridistribuisco per ridurre le chiamate tra shard diversi, con al più (1 + imbalance) volte gli
+    // oggetti medi per shard. Gli spostamenti usano migrate(). Chiamata dal loop di uno shard del pool
+    // (ad esempio da una slot accodata) non sposta nulla e restituisce un esito vuoto
+    SPlacementReport rebalance(double imbalance = 0.25);
+
+    // Ripartizionamento periodico in un thread del pool (0 lo disattiva)
+    void setRebalanceInterval(std::chrono::milliseconds interval);
+
+    // Esito dell'ultimo rebalance()
+    SPlacementReport placementReport() const;
+
+    // Shard dell'oggetto (size() se non è assegnato a questo pool)
+    std::size_t shardOf(const SObject* object) const;
+
+    // Tempo massimo che ogni iterazione del loop dedica alle slot idle (default 1 ms)
+    void setIdleBudget(std::chrono::nanoseconds budget);
+
+    // Contatori dello shard: chiamate accodate ed eseguite, slot idle eseguite
+    std::uint64_t postedCount(std::size_t shard) const;
+    std::uint64_t executedCount(std::size_t shard) const;
+    std::uint64_t idleExecutedCount(std::size_t shard) const;
+
+private:
+    std::vector<_sobject::_EventShard*> m_shards;
+
+    // Thread del ripartizionamento periodico e ultimo esito (il thread parte al primo setRebalanceInterval)
+    _sobject::_Balancer* m_balancer = nullptr;
+
+    std::atomic<bool> m_stopped{false};
+};
+
+#endif // SOBJECT_THREAD_SAFE
+
+
+
+// =======================================
+//
+//               Invoke
+//
+// =======================================
+
+// Risultato di una invoke. Lo stato condiviso viene preso da un pool ed è anche la chiamata accodata,
+// quindi una invoke non alloca altro. Il valore si legge una volta con get() (che attende), oppure
+// lo riceve una continuazione registrata con then() o, dal C++20, un co_await.
+// Continuazioni e coroutine riprendono nel thread che completa la chiamata, cioè quello del receiver
+template <typename T>
+class SFuture
+{
+public:
+    SFuture() {};
+
+    // Usato da invoke
+    explicit SFuture(_sobject::_FutureState<T>* state) : m_state(state) {};
+
+    SFuture(const SFuture&) = delete;
+    SFuture& operator=(const SFuture&) = delete;
+
+    SFuture(SFuture&& other) : m_state(other.m_state)
+    {
+        other.m_state = nullptr;
+    }
+
+    SFuture& operator=(SFuture&& other)
+    {
+        if(this != &other)
+        {
+            if(m_state != nullptr) m_state->release();
+            m_state       = other.m_state;
+            other.m_state = nullptr;
+        }
+
+        return *this;
+    }
+
+    ~SFuture()
+    {
+        if(m_state != nullptr) m_state->release();
+    }
+
+    // Falso per un future costruito di default o già passato a then(). Su un future non valido
+    // isReady() e isCancelled() restituiscono false, gli altri metodi lanciano std::future_error (no_state)
+    bool isValid() const
+    {
+        return m_state != nullptr;
+    }
+
+    bool isReady() const
+    {
+        return m_state != nullptr and m_state->isReady();
+    }
+
+    // Receiver distrutto (o loop chiuso) prima della chiamata: get() restituisce un valore costruito di default
+    bool isCancelled() const
+    {
+        return isReady() and m_state->isCancelled();
+    }
+
+    // Attende il risultato. Dal thread di un loop conviene then() o co_await, l'attesa blocca il loop
+    void wait() const
+    {
+        checkState();
+        m_state->wait();
+    }
+
+    // Attende e restituisce il valore, da chiamare una volta sola.
+    // Se il metodo è terminato con un'eccezione la rilancia
+    T get()
+    {
+        wait();
+        return m_state->take();
+    }
+
+    // Chiama fn con il valore quando la chiamata termina (subito se è già terminata), il future non è più valido.
+    // Una chiamata annullata o terminata con un'eccezione non chiama fn (l'eccezione viene scartata)
+    template <typename Fn>
+    void then(Fn&& fn)
+    {
+        typedef Then<typename std::decay<Fn>::type> Call;
+
+        checkState();
+        _sobject::_FutureState<T>* state = m_state;
+        m_state                          = nullptr;
+
+        if(state->isReady())
+        {
+            Call call{state, std::forward<Fn>(fn)};
+            call();
+            state->release();
+            return;
+        }
+
+        // La continuazione eredita il riferimento del future
+        if(state->suspend(Call{state, std::forward<Fn>(fn)}, true)) return;
+
+        // Chiamata terminata nel frattempo: eseguo qui la continuazione registrata
+        state->resume();
+    }
+
+#ifdef __cpp_impl_coroutine
+    // co_await: la coroutine riprende nel thread del receiver, una chiamata annullata restituisce un valore
+    // costruito di default, l'eccezione del metodo viene rilanciata nella coroutine
+    bool await_ready() const
+    {
+        checkState();
+        return m_state->isReady();
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        if(m_state->suspend(Resume{handle}, false)) return true;
+
+        m_state->discardContinuation();
+        return false;
+    }
+
+    T await_resume()
+    {
+        return m_state->take();
+    }
+#endif
+
+private:
+    void checkState() const
+    {
+        if(m_state == nullptr) throw std::future_error(std::future_errc::no_state);
+    }
+
+    template <typename Fn>
+    struct Then
+    {
+        _sobject::_FutureState<T>* state;
+        Fn fn;
+
+        void operator()()
+        {
+            if(not state->isCancelled() and not state->hasFailed()) state->apply(fn);
+        }
+    };
+
+#ifdef __cpp_impl_coroutine
+    struct Resume
+    {
+        std::coroutine_handle<> handle;
+
+        void operator()()
+        {
+            handle.resume();
+        }
+    };
+#endif
+
+    _sobject::_FutureState<T>* m_state = nullptr;
+};
+
+namespace _sobject
+{
+// Implementazione comune delle invoke
+template <typename Value, typename... Params, typename Receiver, typename Method, typename... Args>
+SFuture<Value> _invoke(Receiver* receiver, Method method, Args&&... args)
+{
+    static_assert(std::is_void<Value>::value or std::is_default_constructible<Value>::value,
+                  "invoke: the return type must be default constructible (value of a cancelled call)");
+
+    typedef _InvokeCall<Value, Receiver, Method, Params...> Call;
+    Call* call = _FuturePool<Call>::acquire();
+
+#ifdef SOBJECT_THREAD_SAFE
+    // Receiver di un altro shard: la chiamata passa dalla coda del suo loop
+    if(_EventShard* shard = _queuedShard(receiver, false))
+    {
+        call->prepare(2);
+        call->bind(receiver, method, std::forward<Args>(args)...);
+        _postTask(shard, call, false);
+        return SFuture<Value>(call);
+    }
+#endif
+
+    call->prepare(1);
+    call->execute(receiver, method, std::forward<Args>(args)...);
+    return SFuture<Value>(call);
+}
+}
+
+// Chiama il metodo nel thread dello shard del receiver e restituisce un future con il suo risultato.
+// I parametri vengono copiati come per SQueuedConnection. Per un receiver senza shard, dal thread del
+// suo stesso shard o senza SOBJECT_THREAD_SAFE la chiamata è diretta e il future è già pronto
+template <typename Receiver, typename R, typename... Params, typename... Args>
+SFuture<typename std::decay<R>::type> invoke(Receiver* receiver, R(Receiver::*method)(Params...), Args&&... args)
+{
+    return _sobject::_invoke<typename std::decay<R>::type, Params...>(receiver, method, std::forward<Args>(args)...);
+}
+
+template <typename Receiver, typename R, typename... Params, typename... Args>
+SFuture<typename std::decay<R>::type> invoke(Receiver* receiver, R(Receiver::*method)(Params...) const, Args&&... args)
+{
+    return _sobject::_invoke<typename std::decay<R>::type, Params...>(receiver, method, std::forward<Args>(args)...);
+}
+
+
+
+// =======================================
+//
+//               Sender
+//
+// =======================================
+
+// Adattatori sender/receiver (P2300): onEmit() espone il prossimo emit di un segnale come sender,
+// toSlot() trasforma una slot in un receiver. I membri seguono la forma di std::execution
+// (connect, start, set_value, set_error, set_stopped); con una libreria standard che lo fornisce
+// (__cpp_lib_senders) dichiarano anche i tag dei concept. Il valore viene consegnato nel thread
+// che effettua l'emit, senza passare da un event loop.
+// onEmit() richiede C++17: connect() restituisce lo stato dell'operazione, non spostabile, per valore
+// (copy elision garantita). toSlot() è disponibile anche in C++11
+
+#if __cplusplus >= 201703L
+// Stato dell'operazione: una connect single shot dal segnale a se stesso, effettuata da start().
+// Lo stato non è spostabile (come richiesto da P2300) e, se viene distrutto prima dell'emit, la
+// connect viene rimossa. Un'operazione avviata termina una sola volta: set_value all'emit,
+// set_stopped se la connect viene rimossa prima (distruzione dell'emitter o disconnect),
+// set_error se la connect non può essere effettuata (es. std::bad_alloc)
+template <typename Emitter, typename Receiver, typename... Args>
+class SEmitOperation : public SObject
+{
+public:
+#ifdef __cpp_lib_senders
+    using operation_state_concept = std::execution::operation_state_t;
+#endif
+
+    SEmitOperation(SObject* emitter, void(Emitter::*signal)(Args...), Receiver&& receiver)
+        : m_emitter(emitter), m_signal(signal), m_receiver(std::move(receiver)) {};
+
+    SEmitOperation(SEmitOperation&&) = delete;
+    SEmitOperation& operator=(SEmitOperation&&) = delete;
+
+    void start() noexcept
+    {
+        try
+        {
+            ::connect(m_emitter, m_signal, this, &SEmitOperation::complete, SSingleShotConnection);
+        }
+        catch(...)
+        {
+            if(finish()) std::move(m_receiver).set_error(std::current_exception());
+        }
+    }
+
+protected:
+    virtual void connectionRemoved() override
+    {
+        if(finish()) std::move(m_receiver).set_stopped();
+    }
+
+private:
+    void complete(Args... args)
+    {
+        if(finish()) std::move(m_receiver).set_value(std::forward<Args>(args)...);
+    }
+
+    // Vero solo per il primo completamento: con SOBJECT_SEQLOCK_EMIT un emit senza lock
+    // può ancora chiamare la slot dopo che la connect è stata rimossa
+    bool finish()
+    {
+#ifdef SOBJECT_THREAD_SAFE
+        return not m_finished.exchange(true, std::memory_order_acq_rel);
+#else
+        if(m_finished) return false;
+        m_finished = true;
+        return true;
+#endif
+    }
+
+    SObject* const m_emitter;
+    void(Emitter::* const m_signal)(Args...);
+    Receiver m_receiver;
+#ifdef SOBJECT_THREAD_SAFE
+    std::atomic<bool> m_finished{false};
+#else
+    bool m_finished = false;
+#endif
+};
+
+// Sender del prossimo emit del segnale: completa con i parametri dell'emit. Non alloca nulla oltre
+// alla slot della connect
+template <typename Emitter, typename... Args>
+class SEmitSender
+{
+public:
+#ifdef __cpp_lib_senders
+    using sender_concept        = std::execution::sender_t;
+    using completion_signatures = std::execution::completion_signatures<std::execution::set_value_t(Args...),
+                                                                        std::execution::set_error_t(std::exception_ptr),
+                                                                        std::execution::set_stopped_t()>;
+#endif
+
+    SEmitSender(SObject* emitter, void(Emitter::*signal)(Args...)) : m_emitter(emitter), m_signal(signal) {};
+
+    template <typename Receiver>
+    SEmitOperation<Emitter, typename std::decay<Receiver>::type, Args...> connect(Receiver&& receiver) const
+    {
+        return SEmitOperation<Emitter, typename std::decay<Receiver>::type, Args...>(m_emitter, m_signal, std::forward<Receiver>(receiver));
+    }
+
+private:
+    SObject* m_emitter;
+    void(Emitter::*m_signal)(Args...);
+};
+
+template <typename Emitter, typename... Args>
+SEmitSender<Emitter, Args...> onEmit(SObject* emitter, void(Emitter::*signal)(Args...))
+{
+    return SEmitSender<Emitter, Args...>(emitter, signal);
+}
+#endif
+
+// Receiver che chiama una slot con il valore del sender. Una slot non ha un canale di errore:
+// errori e interruzioni non la chiamano
+template <typename Receiver, typename... Args>
+class SSlotReceiver
+{
+public:
+#ifdef __cpp_lib_senders
+    using receiver_concept = std::execution::receiver_t;
+#endif
+
+    SSlotReceiver(Receiver* receiver, void(Receiver::*slot)(Args...)) : m_receiver(receiver), m_slot(slot) {};
 
-    // Metodo per eseguire la slot
-    virtual void exec(Args&&... args) override
+    template <typename... Values>
+    void set_value(Values&&... values) && noexcept
     {
-        (m_receiver->*m_method)(std::forward<Args...>(args)...);
+        (m_receiver->*m_slot)(std::forward<Values>(values)...);
     }
 
+    template <typename Error>
+    void set_error(Error&&) && noexcept {}
 
-
-    // ===============================
-    //
-    //  Variabili
+    void set_stopped() && noexcept {}
 
 private:
     Receiver* m_receiver;
-    void(Receiver::*m_method)(Args...);
+    void(Receiver::*m_slot)(Args...);
 };
 
+template <typename Receiver, typename... Args>
+SSlotReceiver<Receiver, Args...> toSlot(Receiver* receiver, void(Receiver::*slot)(Args...))
+{
+    return SSlotReceiver<Receiver, Args...>(receiver, slot);
+}
+
 
 
+#ifdef SOBJECT_THREAD_SAFE
+
 // =======================================
 //
-//              SignalBase
+//             SlotScheduler
 //
 // =======================================
 
-class _SignalBase
+// Il bit di una risorsa è lo stesso hash degli stripe
+inline std::uint64_t SAccess::bit(const void* resource)
 {
-protected:
-    // Costruttori protected in modo che solo Signal possa creare oggetti di questo tipo
-    _SignalBase() = default;
-    _SignalBase(const _SignalBase&) = delete;
-
-public:
-    virtual ~_SignalBase() {};
-
-
-
-    // ===============================
-    //
-    //  Metodi astratti
+    return _sobject::_stripeMask(resource);
+}
 
+// Esegue le slot di un emit, o di un gruppo di emit, su più thread. Le slot connesse con SAccess
+// dichiarano le risorse che leggono e scrivono: due slot sono in conflitto se una scrive una risorsa
+// dell'altra, e quelle in conflitto vengono eseguite una dopo l'altra nell'ordine dell'emit (le slot
+// senza SAccess sono in conflitto con tutte). Le altre vengono eseguite in parallelo dai thread dello
+// scheduler e dal thread che chiama run(), senza lock nei receiver.
+// Le slot sono quelle connesse al momento di post(): una slot disconnessa prima della sua esecuzione
+// viene saltata, quelle connesse dopo non vengono chiamate. Le connect di SStaticGraph non passano
+// dallo scheduler. Post e run vanno chiamate da un solo thread alla volta e non da una slot: run() attende
+// slot che possono aver bisogno del lock dell'emit in corso
+class SSlotScheduler
+{
 public:
-    virtual bool compareByPointer(const _SignalBase* other) const = 0;
-    virtual void removeSlotByReceiver(const SObject* receiver) = 0;
-    virtual bool connectedWithObject(const SObject* receiver) = 0;
-    virtual std::list<SObject*> getAllReceivers() const = 0;
-
-
+    // Con threads == 0 uso un thread per ogni core disponibile oltre a quello che chiama run()
+    explicit SSlotScheduler(std::size_t threads = 0);
+    SSlotScheduler(const SSlotScheduler&) = delete;
+    SSlotScheduler& operator=(const SSlotScheduler&) = delete;
+    ~SSlotScheduler();
+
+    // Accodo un emit: le slot connesse ora verranno eseguite dalla prossima run()
+    template <typename Emitter, typename... Args, typename... Values>
+    void post(SObject* emitter, void(Emitter::* const signalM)(Args...), Values&&... values)
+    {
+        static_assert(sizeof...(Args) == sizeof...(Values), "Numero di parametri diverso da quello del segnale");
+        post(emitter, _sobject::_makeMethodKey(signalM), new _sobject::_ScheduledSignal<Emitter, Args...>(std::forward<Values>(values)...));
+    }
 
-    // ===============================
-    //
-    //  CustomSignalCompare
+    // Eseguo le slot degli emit accodati e attendo la fine
+    void run();
 
-public:
-    struct CustomSignalCompare
+    // Emit singolo: post() e run()
+    template <typename Emitter, typename... Args, typename... Values>
+    void emit(SObject* emitter, void(Emitter::* const signalM)(Args...), Values&&... values)
     {
-        CustomSignalCompare() = delete;
-        CustomSignalCompare(const _SignalBase* signal, const bool& deleteObject= false) : m_deleteObject(deleteObject), m_signal(signal){};
-
-        bool operator()(const _sobject::_SignalBase* signal) const
-        {
-            // Controllo se il segnale chiave è uguale a quello che si sta cercando
-            bool result = signal->compareByPointer(m_signal);
+        post(emitter, signalM, std::forward<Values>(values)...);
+        run();
+    }
 
-            // Controllo se eliminare il segnale
-            if(result and m_deleteObject)
-            {
-                delete signal;
-            }
+    // Numero di thread dello scheduler (escluso quello che chiama run())
+    std::size_t size() const;
 
-            // Restituisco il risultato
-            return result;
-        }
+private:
+    void post(SObject* emitter, const _sobject::_MethodKey& key, _sobject::_ScheduledEmit* emit);
 
-        const bool m_deleteObject   = false;
-        const _SignalBase* m_signal = nullptr;
-    };
+    _sobject::_Scheduler* m_scheduler;
 };
 
+#endif // SOBJECT_THREAD_SAFE
+
 
 
 // =======================================
 //
-//               Signal
+//             SObjectArray
 //
 // =======================================
 
-template <typename Emitter, typename... Args>
-class _Signal : public _SignalBase
+// Elementi dello stesso tipo memorizzati in modo contiguo, con le connect di tutti gli elementi
+// in tabelle condivise (una per segnale) indicizzate per elemento. emitRange emette il segnale
+// su un intervallo di elementi cercando il segnale una sola volta, invece di un emitSignal per elemento.
+// Le connect dell'array sono distinte da quelle fatte sul singolo elemento: emitRange chiama solo le prime,
+// emitSignal dell'elemento solo le seconde. La separazione è voluta: gli elementi restano SObject ordinari,
+// spostati dal vettore quando cresce, e portare i loro emit nelle tabelle richiederebbe in ogni SObject
+// l'array e l'indice, più una seconda ricerca a ogni emitSignal. L'array è l'emitter delle sue connect (il receiver
+// le rimuove alla distruzione come le altre), per questo non può essere usato come SObject esterno
+template <typename T>
+class SObjectArray : private SObject
 {
+    static_assert(std::is_base_of<SObject, T>::value, "Gli elementi devono essere SObject");
+
 public:
-    // Anche se i costruttori sono pubblici non utilizzare le seguenti classi
-    _Signal() = delete;
-    _Signal(const _Signal&) = delete;
-    _Signal(void(Emitter::* const signal)(Args...)) : m_signal(signal){};
-    virtual ~_Signal()
-    {
-        // Per ogni slot
-        for(auto slot : m_slots)
-        {
-            // Dealloco oggetto
-            delete slot;
-        }
-    };
+    SObjectArray() {};
+    explicit SObjectArray(std::size_t count) : m_objects(count) {};
+
+    SObjectArray(SObjectArray&&) = default;
+    SObjectArray& operator=(SObjectArray&&) = default;
 
 
 
     // ===============================
     //
-    //  Override
+    //  Elementi
 
 public:
-    // Confronto di due SignalBase tramite puntatori (override)
-    virtual bool compareByPointer(const _SignalBase* other) const override
+    std::size_t size() const
     {
-        auto signal = dynamic_cast<const _Signal<Emitter, Args...>*>(other);
-        if(signal == nullptr) return false;
-
-        return m_signal  == signal->m_signal;
+        return m_objects.size();
     }
 
-    // Rimuovo tutte le slot del receiver
-    virtual void removeSlotByReceiver(const SObject* receiver) override
+    T& operator[](std::size_t index)
     {
-        m_slots.remove_if(typename _SlotBase<Args...>::CustomSlotCompare(receiver));
+        return m_objects[index];
     }
 
-    virtual bool connectedWithObject(const SObject* receiver) override
+    const T& operator[](std::size_t index) const
     {
-        // Controllo se ci sono slot del receiver
-        return m_slots.end() !=
-                    std::find_if(m_slots.begin(),
-                    m_slots.end(),
-                    typename _sobject::_SlotBase<Args...>::CustomSlotCompare(receiver, false));
+        return m_objects[index];
     }
 
-    virtual std::list<SObject*> getAllReceivers() const override
+    T* data()
     {
-        std::list<SObject*> list_t;
-
-        for(_SlotBase<Args...>* slot : m_slots)
-        {
-            list_t.push_back(slot->getReceiver());
-        }
-
-        return list_t;
+        return m_objects.data();
     }
 
+    typename std::vector<T>::iterator begin() { return m_objects.begin(); }
+    typename std::vector<T>::iterator end()   { return m_objects.end(); }
 
-
-    // ===============================
-    //
-    //  Interfacce esterne
-
-    template <typename Receiver>
-    void addSlot(_sobject::_Slot<Receiver, Args...>* slot)
-    {
-        m_slots.push_back(slot);
-    }
-
-    void removeSlot(SObject* receiver)
+    // La crescita sposta gli elementi (con le loro connect), le connect dell'array restano sugli indici
+    void reserve(std::size_t count)
     {
-        m_slots.remove_if(typename _SlotBase<Args...>::CustomSlotCompare(receiver));
+        m_objects.reserve(count);
     }
 
-    template <typename Receiver>
-    void removeSlot(_sobject::_Slot<Receiver, Args...>* slot)
+    template <typename... CtorArgs>
+    T& emplace_back(CtorArgs&&... args)
     {
-        m_slots.remove_if(typename _SlotBase<Args...>::CustomSlotCompare(slot));
+        m_objects.emplace_back(std::forward<CtorArgs>(args)...);
+        return m_objects.back();
     }
 
-    void execAllSlots(Args&&... args)
+    // Riducendo la dimensione vengono rimosse anche le connect dell'array degli elementi eliminati
+    void resize(std::size_t count)
     {
-        for(_SlotBase<Args...>* slot : m_slots)
+        if(count < m_objects.size())
         {
-            slot->exec(std::forward<Args...>(args)...);
+            _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(object()));
+            for(_sobject::_SignalBase* signal : m_signalsList) static_cast<_sobject::_ArraySignalBase*>(signal)->removeElementsFrom(count);
         }
+
+        m_objects.resize(count);
     }
 
 
 
     // ===============================
     //
-    //  Variabili
-
-private:
-    // Segnale
-    void(Emitter::* const m_signal)(Args...);
-    std::list<_SlotBase<Args...>*> m_slots;
-};
-
-} // namespace _sobject
-
-
-
-
-
-
-
-
+    //  Connect
 
-/* ===========================================================================
- *
- *    Di seguito sono presenti le classi e i metodi da utilizzare.
- *
- * ===========================================================================
- */
-
-// =======================================
-//
-//               SObject
-//
-// =======================================
-
-class SObject
-{
 public:
-    SObject(){};
-    virtual ~SObject()
+    // Connect della slot al segnale dell'elemento index.
+    // Restituisce false se index non è un elemento dell'array (index >= size(), o oltre i 2^32 elementi
+    // indicizzabili dalle tabelle), per SUniqueConnection se l'elemento ha già la slot, e per le connect
+    // single shot o con replay, non supportate dagli array
+    template <typename Emitter, typename Receiver, typename... Args>
+    bool connect(std::size_t index, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...), SConnectionType type = SDefaultConnection)
     {
-        // Effettuo il reset delle connect
-        disconnect(this);
+        static_assert(std::is_base_of<Emitter, T>::value, "Il segnale deve appartenere al tipo degli elementi");
 
-        // Per ogni SObject che ha una connect con il seguente oggetto
-        for(SObject* sObject : m_slotToSignalObjectList)
-        {
-            // Per ogni segnale di tale oggetto
-            for(auto signal : sObject->m_signalsList)
-            {
-                signal->removeSlotByReceiver(this);
-            }
-        }
+        if(index >= m_objects.size() or index > _sobject::_ArraySignalBase::maxElement) return false;
+        if(type & (SSingleShotConnection | SReplayLastConnection | SReplayAllConnection)) return false;
 
-        m_slotToSignalObjectList.clear();
-    };
+        _sobject::_Slot<Receiver, Args...>* slot = new _sobject::_Slot<Receiver, Args...>(receiver, slotM, type);
 
+        _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(object()));
 
+        _sobject::_ArraySignal<Emitter, Args...>* signal = arraySignalFor(signalM);
+        if((type & SUniqueConnection) and signal->containsElementSlot(index, slot))
+        {
+            delete slot;
+            return false;
+        }
 
-    // ===============================
-    //
-    //  Emit
+        signal->addElementSlot(index, slot);
+        slot->link(object());
+        return true;
+    }
 
-protected:
-    template <typename Emitter, typename... Args>
-    void emitSignal(void(Emitter::* const signalM)(Args...), Args... args) const
+    // Rimuovo le slot uguali a quella in input dal segnale dell'elemento
+    template <typename Emitter, typename Receiver, typename... Args>
+    void disconnect(std::size_t index, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...))
     {
-        // Creo un segnale temporaneo per cercarlo
-        auto signal = new _sobject::_Signal<Emitter, Args...>(signalM);
-
-        // Cerco il segnale
-        auto signalIterator = std::find_if(m_signalsList.begin(), m_signalsList.end(), _sobject::_SignalBase::CustomSignalCompare(signal));
-        if(signalIterator == m_signalsList.end())
-        {
-            delete signal;
-            return;
-        }
+        // Oltre maxElement non ci sono connect (e l'indice troncato sarebbe quello di un altro elemento)
+        if(index > _sobject::_ArraySignalBase::maxElement) return;
 
-        // Effettuo il cast al tipo di segnale
-        _sobject::_Signal<Emitter, Args...>* slotContainer = dynamic_cast<_sobject::_Signal<Emitter, Args...>*>(*signalIterator);
-        if(slotContainer == nullptr)
-        {
-            delete signal;
-            return;
-        }
+        _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(object()));
 
-        // Chiamo tutte le slot
-        slotContainer->execAllSlots(std::forward<Args...>(args)...);
+        _sobject::_SignalBase* signal = findSignal(_sobject::_makeMethodKey(signalM));
+        if(signal == nullptr) return;
 
-        delete signal;
-        return;
+        const _sobject::_Slot<Receiver, Args...> slot(receiver, slotM);
+        static_cast<_sobject::_ArraySignalBase*>(signal)->removeElementSlot(index, &slot);
     }
 
 
 
     // ===============================
     //
-    //  Metodi esterni
+    //  Emit
 
 public:
-    bool connectedWithObject(SObject* receiver) const
+    // Emetto il segnale degli elementi in [first, last): il segnale viene cercato una volta e le slot
+    // vengono chiamate scorrendo la tabella ordinata per elemento. argsFn(T& elemento, std::size_t indice)
+    // restituisce i parametri dell'emit (il valore, o una std::tuple se il segnale ne ha più di uno)
+    // e viene chiamata solo per gli elementi con almeno una connect.
+    // Se una slot modifica le connect dell'array l'emit riprende dalla slot successiva dello stesso
+    // elemento (le slot già chiamate vengono saltate, argsFn viene chiamata di nuovo per l'elemento).
+    // Come per emitSignal, le connect effettuate durante l'emit non vengono chiamate da lui
+    template <typename Emitter, typename ArgsFn, typename... Args>
+    void emitRange(void(Emitter::*signalM)(Args...), std::size_t first, std::size_t last, ArgsFn argsFn)
     {
-        // Per ogni segnale
-        for(auto signal : m_signalsList)
-        {
-            if(signal->connectedWithObject(receiver))
-            {
-                return true;
-            }
-        }
-
-        return false;
-    }
+        static_assert(std::is_base_of<Emitter, T>::value, "Il segnale deve appartenere al tipo degli elementi");
 
-    std::list<SObject*> getAllReceivers(_sobject::_SignalBase* signalIn = nullptr) const
-    {
-        // Creo la lista dei ricevitori
-        std::list<SObject*> allReceiver;
+        last = std::min(last, m_objects.size());
 
-        // Per ogni segnale
-        for(const _sobject::_SignalBase* signal : m_signalsList)
-        {
-            // Se si vogliono i receiver di un solo signal controllo se è quello in input
-            if(signal == nullptr or (signalIn != nullptr and not signal->compareByPointer(signalIn))) continue;
+        _sobject::_StripeReadLock readLock(object());
 
-            // Recupero tutti i receiver del segnale
-            std::list<SObject*> signalReceivers = signal->getAllReceivers();
+        const _sobject::_MethodKey key = _sobject::_makeMethodKey(signalM);
+        _sobject::_SignalBase* const signal = findSignal(key);
+        if(signal == nullptr) return;
 
-            // Salvo tutti i receiver di questo segnale
-            allReceiver.insert(allReceiver.begin(), signalReceivers.begin(), signalReceivers.end());
-        }
+        // Il segnale resta valido per tutto l'emit (anche se rimosso da una slot o da un altro thread)
+        _sobject::_IterationScope scope(signal);
+        _sobject::_ArraySignal<Emitter, Args...>* arraySignal = static_cast<_sobject::_ArraySignal<Emitter, Args...>*>(signal);
+        std::vector<_sobject::_SlotCore*> called;
 
-        // Ordino tutti i receiver (per poi chiamare unique)
-        allReceiver.sort();
+        // Le connect effettuate durante l'emit vengono chiamate dagli emit successivi
+        const std::size_t serial = arraySignal->nextSerial();
 
-        // Chiamo unique ed elimino le ripetizioni
-        auto _allReceiver = std::unique(allReceiver.begin(), allReceiver.end());
-        allReceiver.erase(_allReceiver, allReceiver.end());
+        while(first < last)
+        {
+            // La tabella viene ricostruita con il lock esclusivo, mentre il lock passa
+            // da condiviso a esclusivo il segnale può essere rimosso: in tal caso l'emit termina
+            while(arraySignal->isStale())
+            {
+                _sobject::_StripeWriteLock writeLock(_sobject::_stripeMask(object()));
+                if(findSignal(key) != signal) return;
+                if(arraySignal->isStale()) arraySignal->rebuild();
+            }
 
-        return allReceiver;
+            first = arraySignal->execRange(m_objects, first, last, argsFn, serial, called);
+        }
     }
 
 
@@ -461,234 +4105,223 @@ public:
     //  Metodi interni
 
 private:
-    void removeAllSignal()
+    SObject* object()
     {
-        // Per ogni segnale
-        for(auto signal : m_signalsList)
-        {
-            // Elimino segnale
-            delete signal;
-        }
+        return this;
+    }
 
-        // Clear della mappa
-        m_signalsList.clear();
+    // Cerco il segnale dell'array, se non esiste lo creo
+    template <typename Emitter, typename... Args>
+    _sobject::_ArraySignal<Emitter, Args...>* arraySignalFor(void(Emitter::* const signalM)(Args...))
+    {
+        _sobject::_SignalBase* signal = findSignal(_sobject::_makeMethodKey(signalM));
+        if(signal != nullptr) return static_cast<_sobject::_ArraySignal<Emitter, Args...>*>(signal);
+
+        _sobject::_ArraySignal<Emitter, Args...>* newSignal = new _sobject::_ArraySignal<Emitter, Args...>(signalM);
+        m_signalsList.push_back(newSignal);
+#ifdef SOBJECT_SEQLOCK_EMIT
+        publishSignals();
+#endif
+        return newSignal;
     }
 
 
 
     // ===============================
     //
-    //  Strutture interne
+    //  Variabili
 
 private:
-    std::list<_sobject::_SignalBase*> m_signalsList;
-    std::list<SObject*> m_slotToSignalObjectList;
-
+    std::vector<T> m_objects;
+};
 
 
-    // ===============================
-    //
-    //  Friend
 
-    template<typename E, typename R, typename... Args>
-    friend void connect(SObject* emitter, void(E::*signalM)(Args...), R* receiver, void(R::*slotM)(Args...));
+// =======================================
+//
+//               Prefab
+//
+// =======================================
 
-    template<typename Emitter, typename Receiver, typename... Args>
-    friend void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...));
+// Gruppo di oggetti collegati tra loro, usato come modello: le connect interne (emitter e receiver
+// entrambi nel gruppo) vengono catturate una volta, poi instantiate le replica su altri oggetti degli
+// stessi tipi clonando le slot in blocco: un lock, una ricerca del segnale e un'invalidazione per ogni
+// (emitter, segnale), nessun controllo per connect. Il modello può essere distrutto dopo la cattura
+template <typename... Objects>
+class SPrefab
+{
+public:
+    explicit SPrefab(Objects*... objects) : m_prefab({ static_cast<SObject*>(objects)... }) {};
 
-    template<typename Emitter, typename Receiver, typename... Args>
-    friend void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver);
+    void instantiate(Objects*... objects) const
+    {
+        m_prefab.instantiate({ static_cast<SObject*>(objects)... });
+    }
 
-    template<typename Emitter, typename... Args>
-    friend void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...));
+    // Numero di connect replicate da ogni istanza
+    std::size_t connectionCount() const
+    {
+        return m_prefab.connectionCount();
+    }
 
-    friend void disconnect(SObject* emitter);
+private:
+    _sobject::_Prefab m_prefab;
 };
 
 
 
-
-
-
-
-
-
 // =======================================
 //
-//               Connect
+//            Static graph
 //
 // =======================================
 
-template<typename Emitter, typename Receiver, typename... Args>
-void connect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...))
+// Connect statica tra un segnale e una slot, entrambi noti a tempo di compilazione.
+// In C++11 si dichiara con S_CONN(&A::signal, &B::slot), dal C++17 con SConn<&A::signal, &B::slot>
+template <typename SignalT, SignalT Signal, typename SlotT, SlotT Slot>
+struct SConnT
 {
-    // Creo l'oggetto per identificare il segnale
-    _sobject::_Signal<Emitter, Args...>* signal = new _sobject::_Signal<Emitter, Args...>(signalM);
-
-    // Creo l'oggetto per identificare la slot
-    _sobject::_Slot<Receiver, Args...>* slot = new _sobject::_Slot<Receiver, Args...>(receiver, slotM);
-
-    // Controllo se il segnale ha delle slot registrate
-    auto signalFound = std::find_if(emitter->m_signalsList.begin(), emitter->m_signalsList.end(), _sobject::_SignalBase::CustomSignalCompare(signal));
-    if(signalFound != emitter->m_signalsList.end())
-    {
-        // Effettuo il cast al tipo di segnale
-        _sobject::_Signal<Emitter, Args...>* slotContainer = dynamic_cast<_sobject::_Signal<Emitter, Args...>*>(*signalFound);
-        if(slotContainer == nullptr)
-        {
-            delete signal;
-            delete slot;
-            return;
-        }
+    static_assert(std::is_same<typename _sobject::_MethodTraits<SignalT>::ArgsType,
+                               typename _sobject::_MethodTraits<SlotT>::ArgsType>::value,
+                  "Il segnale e la slot devono avere gli stessi parametri");
 
-        // Salvo la nuova slot
-        slotContainer->addSlot(slot);
+    typedef SignalT SignalType;
+    typedef typename _sobject::_MethodTraits<SignalT>::ClassType Emitter;
+    typedef typename _sobject::_MethodTraits<SlotT>::ClassType Receiver;
 
-        delete signal;
-    }
-    else
+    static SignalT signal()
     {
-        // Se è la prima connect aggiungo la slot alla connect e la signal all'emitter
-        signal->addSlot(slot);
-        emitter->m_signalsList.push_back(signal);
+        return Signal;
     }
 
-    // Controllo se il ricevitore non ha il segnale registrato
-    auto listIt = std::find(receiver->m_slotToSignalObjectList.begin(), receiver->m_slotToSignalObjectList.end(), emitter);
-    if(listIt == receiver->m_slotToSignalObjectList.end())
+    // Chiamata diretta della slot (inlinabile)
+    template <typename... Args>
+    static void call(Receiver* receiver, Args&... args)
     {
-        // Registro il segnale
-        receiver->m_slotToSignalObjectList.push_back(emitter);
+        (receiver->*Slot)(args...);
     }
-}
-
+};
 
+#define S_CONN(signal, slot) SConnT<decltype(signal), signal, decltype(slot), slot>
 
-// =======================================
-//
-//             Disconnect
-//
-// =======================================
+#if __cplusplus >= 201703L or (defined(_MSVC_LANG) and _MSVC_LANG >= 201703L)
+template <auto Signal, auto Slot>
+using SConn = SConnT<decltype(Signal), Signal, decltype(Slot), Slot>;
+#endif
 
-template<typename Emitter, typename Receiver, typename... Args>
-void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver, void(Receiver::*slotM)(Args...))
+// Grafo di connect statiche. Le istanze vengono legate alla costruzione (una per classe),
+// e gli emitter che dichiarano "typedef Grafo SStaticWiring;" chiamano direttamente le slot
+// del grafo a ogni emitSignal, prima delle slot connesse a runtime.
+// I receiver devono vivere almeno quanto il grafo
+template <typename... Conns>
+class SStaticGraph : public _sobject::_StaticGraphBase
 {
-    // Creo l'oggetto per identificare il segnale e la slot
-    _sobject::_Signal<Emitter, Args...> *signal = new _sobject::_Signal<Emitter, Args...>(signalM);
-    _sobject::_Slot<Receiver, Args...>  *slot   = new _sobject::_Slot<Receiver, Args...>(receiver, slotM);
+public:
+    typedef SStaticGraph Graph;
 
-    // Prima lavoro sull'emitter
-    // Trovo il segnale nell'emitter
-    auto emitterSignal = std::find_if(emitter->m_signalsList.begin(), emitter->m_signalsList.end(), _sobject::_SignalBase::CustomSignalCompare(signal));
-    if(emitterSignal == emitter->m_signalsList.end())
+    template <typename... Objects>
+    explicit SStaticGraph(Objects*... objects) : m_receivers(_sobject::_findObject<typename Conns::Receiver>(objects...)...)
     {
-        delete signal;
-        delete slot;
-        return;
+        static_assert(_sobject::_AllTrue<_sobject::_HasObject<typename Conns::Receiver, Objects...>::value...>::value,
+                      "Ogni receiver del grafo deve essere tra gli oggetti legati");
+
+        // Lego gli oggetti che dichiarano questo grafo come SStaticWiring
+        int expand[] = { 0, (bind(objects, _sobject::_IsWiredTo<Objects, SStaticGraph>()), 0)... };
+        (void)expand;
     }
 
-    // Effettuo il cast
-    _sobject::_Signal<Emitter, Args...>* signalT = dynamic_cast<_sobject::_Signal<Emitter, Args...>*>(*emitterSignal);
-    if(signalT == nullptr)
+    ~SStaticGraph()
     {
-        delete signal;
-        delete slot;
-        return;
+        for(SObject* object : m_bound)
+        {
+            if(object->m_staticGraph == this) object->m_staticGraph = nullptr;
+        }
     }
 
-    // Rimuovo slot
-    signalT->removeSlot(slot);
 
-    // Dopo lavoro sul receiver
-    // Controllo che tra tutti i signal dell'emitter non ci siano connect con slot del receiver
-    if(not emitter->connectedWithObject(receiver))
+
+    // ===============================
+    //
+    //  Dispatch
+
+public:
+    // Chiamo le slot connesse staticamente al segnale (i confronti sono tra costanti)
+    template <typename SignalT, typename... Args>
+    void dispatch(SignalT signalM, Args&... args) const
     {
-        // Rimuovo l'emitter dal receiver
-        dynamic_cast<SObject*>(receiver)->m_slotToSignalObjectList.remove(emitter);
+        dispatchAll(signalM, typename _sobject::_MakeIndexSequence<sizeof...(Conns)>::type(), args...);
     }
 
-    delete signal;
-    delete slot;
-    return;
-}
+private:
+    template <typename SignalT, std::size_t... I, typename... Args>
+    void dispatchAll(SignalT signalM, _sobject::_IndexSequence<I...>, Args&... args) const
+    {
+        int expand[] = { 0, (dispatchOne<I>(signalM, std::is_same<SignalT, typename std::tuple_element<I, std::tuple<Conns...>>::type::SignalType>(), args...), 0)... };
+        (void)expand;
+    }
 
-template<typename Emitter, typename Receiver, typename... Args>
-void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...), Receiver* receiver)
-{
-    // Creo l'oggetto per identificare il segnale
-    _sobject::_SignalBase* signal = new _sobject::_Signal<Emitter, Args...>(signalM);
+    template <std::size_t I, typename SignalT, typename... Args>
+    void dispatchOne(SignalT, std::false_type, Args&...) const {}
 
-    // Prima lavoro sull'emitter
-    // Cerco il segnale
-    auto emitterSignal = std::find_if(emitter->m_signalsList.begin(), emitter->m_signalsList.end(), _sobject::_SignalBase::CustomSignalCompare(signal));
-    if(emitterSignal == emitter->m_signalsList.end())
+    template <std::size_t I, typename SignalT, typename... Args>
+    void dispatchOne(SignalT signalM, std::true_type, Args&... args) const
     {
-        delete signal;
-        return;
+        typedef typename std::tuple_element<I, std::tuple<Conns...>>::type Conn;
+        if(signalM == Conn::signal()) Conn::call(std::get<I>(m_receivers), args...);
     }
 
-    // Effettuo il cast
-    _sobject::_Signal<Emitter, Args...>* signalT = dynamic_cast<_sobject::_Signal<Emitter, Args...>*>(*emitterSignal);
-    if(signalT == nullptr)
+    void unbind(SObject* object) override
     {
-        delete signal;
-        return;
+        m_bound.erase(std::remove(m_bound.begin(), m_bound.end(), object), m_bound.end());
     }
 
-    // Rimuovo slot
-    signalT->removeSlot(receiver);
-
-    // Dopo lavoro sul receiver
-    // Controllo che tra tutti i signal dell'emitter non ci siano connect con slot del receiver
-    if(not emitter->connectedWithObject(receiver))
+    // Aggiorno l'oggetto legato e le connect in cui è receiver (gli altri receiver non sono noti al grafo)
+    void rebind(SObject* from, SObject* to) override
     {
-        // Rimuovo l'emitter dal receiver
-        dynamic_cast<SObject*>(receiver)->m_slotToSignalObjectList.remove(emitter);
+        std::replace(m_bound.begin(), m_bound.end(), from, to);
+        rebindAll(from, to, typename _sobject::_MakeIndexSequence<sizeof...(Conns)>::type());
     }
 
-    delete signal;
-}
-
-template<typename Emitter, typename... Args>
-void disconnect(SObject* emitter, void(Emitter::*signalM)(Args...))
-{
-    // Creo l'oggetto per identificare il segnale
-    _sobject::_SignalBase* signal = new _sobject::_Signal<Emitter, Args...>(signalM);
+    template <std::size_t... I>
+    void rebindAll(SObject* from, SObject* to, _sobject::_IndexSequence<I...>)
+    {
+        int expand[] = { 0, (rebindOne(std::get<I>(m_receivers), from, to, std::is_base_of<SObject, typename Conns::Receiver>()), 0)... };
+        (void)expand;
+    }
 
-    // Recupero tutti i receiver associati al segnale
-    std::list<SObject*> receiverList = emitter->getAllReceivers(signal);
+    template <typename Receiver>
+    static void rebindOne(Receiver*& receiver, SObject* from, SObject* to, std::true_type)
+    {
+        // Nel costruttore di spostamento to non è ancora un Receiver: sposto il puntatore della stessa distanza
+        if(static_cast<SObject*>(receiver) == from) receiver = reinterpret_cast<Receiver*>(reinterpret_cast<char*>(receiver) + (reinterpret_cast<char*>(to) - reinterpret_cast<char*>(from)));
+    }
 
-    // Rimuovo il segnale
-    emitter->m_signalsList.remove_if(_sobject::_SignalBase::CustomSignalCompare(signal, true));
+    template <typename Receiver>
+    static void rebindOne(Receiver*&, SObject*, SObject*, std::false_type) {}
 
-    // Controllo per tutti i receiver trovati prima se questi hanno altre connect con l'emitter
-    for(SObject* receiver : receiverList)
+private:
+    template <typename Object>
+    void bind(Object* object, std::true_type)
     {
-        // Se l'emitter non ha più connect con il receiver
-        if(not emitter->connectedWithObject(receiver))
-        {
-            // Rimuovo l'emitter dal receiver
-            receiver->m_slotToSignalObjectList.remove(emitter);
-        }
+        object->m_staticGraph = this;
+        m_bound.push_back(object);
     }
 
-    delete signal;
-}
+    template <typename Object>
+    void bind(Object*, std::false_type) {}
 
-void disconnect(SObject* emitter)
-{
-    // Recupero tutti i receiver associati ai segnali dell'emitter
-    std::list<SObject*> receiverList = emitter->getAllReceivers();
 
-    // Rimuovo tutte le connect dall'emitter
-    emitter->removeAllSignal();
 
-    // Per tutti i receiver trovati prima
-    for(SObject* receiver : receiverList)
-    {
-        // Rimuovo l'emitter dal receiver
-        receiver->m_slotToSignalObjectList.remove(emitter);
-    }
-}
+    // ===============================
+    //
+    //  Variabili
+
+private:
+    // Receiver di ogni connect, nello stesso ordine di Conns
+    std::tuple<typename Conns::Receiver*...> m_receivers;
+
+    // Oggetti legati al grafo
+    std::vector<SObject*> m_bound;
+};
 
 #endif // SOBJECT_H
@@ -0,0 +1,188 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#include <string>
+#include <vector>
+
+// SObjectArray: connect per elemento ed emitRange sulle tabelle condivise
+
+namespace
+{
+
+class Particle : public SObject
+{
+public:
+    S_SIGNAL void moved(int) {}
+    S_SIGNAL void named(std::string) {}
+
+    void move(int position)
+    {
+        emitSignal(&Particle::moved, position);
+    }
+
+    int m_position = 0;
+};
+
+class Tracker : public SObject
+{
+public:
+    S_SLOT void onMoved(int position)
+    {
+        m_positions.push_back(position);
+    }
+
+    S_SLOT void onNamed(std::string name)
+    {
+        m_names.push_back(std::move(name));
+    }
+
+    std::vector<int> m_positions;
+    std::vector<std::string> m_names;
+};
+
+// Alla prima chiamata si disconnette dall'elemento index dell'array
+class SelfRemover : public SObject
+{
+public:
+    SelfRemover(SObjectArray<Particle>* array, std::size_t index) : m_array(array), m_index(index) {}
+
+    S_SLOT void onMoved(int position)
+    {
+        m_positions.push_back(position);
+        m_array->disconnect(m_index, &Particle::moved, this, &SelfRemover::onMoved);
+    }
+
+    std::vector<int> m_positions;
+
+private:
+    SObjectArray<Particle>* m_array;
+    std::size_t m_index;
+};
+
+int positionOf(Particle& particle, std::size_t)
+{
+    return particle.m_position;
+}
+
+} // namespace
+
+
+
+S_TEST(arrayEmitRangeCallsSlotsOfElementsInRange)
+{
+    SObjectArray<Particle> particles(4);
+    for(std::size_t i = 0; i < particles.size(); ++i) particles[i].m_position = int(i) * 10;
+
+    Tracker tracker;
+    particles.connect(3, &Particle::moved, &tracker, &Tracker::onMoved);
+    particles.connect(1, &Particle::moved, &tracker, &Tracker::onMoved);
+    particles.connect(0, &Particle::moved, &tracker, &Tracker::onMoved);
+
+    particles.emitRange(&Particle::moved, 1, 4, &positionOf);
+    S_CHECK(tracker.m_positions == std::vector<int>({ 10, 30 }));
+}
+
+S_TEST(arrayByValueArgumentReachesEverySlotOfElement)
+{
+    SObjectArray<Particle> particles(2);
+    Tracker first, second;
+    particles.connect(1, &Particle::named, &first, &Tracker::onNamed);
+    particles.connect(1, &Particle::named, &second, &Tracker::onNamed);
+
+    particles.emitRange(&Particle::named, 0, 2, [](Particle&, std::size_t index) { return std::string(index == 1 ? "element-one" : "other"); });
+
+    S_CHECK(first.m_names == std::vector<std::string>({ "element-one" }));
+    S_CHECK(second.m_names == std::vector<std::string>({ "element-one" }));
+}
+
+S_TEST(arrayConnectRejectsIndexOutOfRange)
+{
+    SObjectArray<Particle> particles(2);
+    Tracker tracker;
+
+    S_CHECK(not particles.connect(2, &Particle::moved, &tracker, &Tracker::onMoved));
+    S_CHECK(not particles.connect(std::size_t(-1), &Particle::moved, &tracker, &Tracker::onMoved));
+    S_CHECK(particles.connect(1, &Particle::moved, &tracker, &Tracker::onMoved));
+
+    // Un indice troncato a 32 bit sarebbe l'elemento 1: la sua connect resta
+    particles.disconnect((std::size_t(1) << 32) + 1, &Particle::moved, &tracker, &Tracker::onMoved);
+    particles.emitRange(&Particle::moved, 0, 2, &positionOf);
+    S_CHECK_EQUAL(tracker.m_positions.size(), std::size_t(1));
+}
+
+S_TEST(arrayEmitResumesAtNextSlotOfSameElement)
+{
+    SObjectArray<Particle> particles(2);
+    particles[0].m_position = 5;
+    particles[1].m_position = 7;
+
+    SelfRemover remover(&particles, 0);
+    Tracker tracker;
+    particles.connect(0, &Particle::moved, &remover, &SelfRemover::onMoved);
+    particles.connect(0, &Particle::moved, &tracker, &Tracker::onMoved);
+    particles.connect(1, &Particle::moved, &tracker, &Tracker::onMoved);
+
+    // La slot dell'elemento 0 si disconnette: l'emit riprende dalla slot successiva dello stesso elemento
+    particles.emitRange(&Particle::moved, 0, 2, &positionOf);
+    S_CHECK(remover.m_positions == std::vector<int>({ 5 }));
+    S_CHECK(tracker.m_positions == std::vector<int>({ 5, 7 }));
+
+    particles.emitRange(&Particle::moved, 0, 2, &positionOf);
+    S_CHECK(remover.m_positions == std::vector<int>({ 5 }));
+    S_CHECK(tracker.m_positions == std::vector<int>({ 5, 7, 5, 7 }));
+}
+
+S_TEST(arrayConnectDuringEmitIsNotCalledByIt)
+{
+    SObjectArray<Particle> particles(2);
+    Tracker tracker;
+    Tracker late;
+
+    struct Connector : SObject
+    {
+        SObjectArray<Particle>* array;
+        Tracker* late;
+
+        S_SLOT void onMoved(int)
+        {
+            array->connect(0, &Particle::moved, late, &Tracker::onMoved);
+            array->connect(1, &Particle::moved, late, &Tracker::onMoved);
+        }
+    } connector;
+    connector.array = &particles;
+    connector.late  = &late;
+
+    particles.connect(0, &Particle::moved, &connector, &Connector::onMoved, SUniqueConnection);
+    particles.connect(1, &Particle::moved, &tracker, &Tracker::onMoved);
+
+    particles.emitRange(&Particle::moved, 0, 2, &positionOf);
+    S_CHECK(late.m_positions.empty());
+    S_CHECK_EQUAL(tracker.m_positions.size(), std::size_t(1));
+}
+
+S_TEST(arrayConnectionsAreSeparateFromElementConnections)
+{
+    SObjectArray<Particle> particles(1);
+    Tracker viaArray, viaElement;
+    particles.connect(0, &Particle::moved, &viaArray, &Tracker::onMoved);
+    connect(&particles[0], &Particle::moved, &viaElement, &Tracker::onMoved);
+
+    particles[0].move(1);
+    particles.emitRange(&Particle::moved, 0, 1, [](Particle&, std::size_t) { return 2; });
+
+    S_CHECK(viaElement.m_positions == std::vector<int>({ 1 }));
+    S_CHECK(viaArray.m_positions == std::vector<int>({ 2 }));
+}
+
+S_TEST(arrayShrinkRemovesConnectionsOfRemovedElements)
+{
+    SObjectArray<Particle> particles(3);
+    Tracker tracker;
+    particles.connect(2, &Particle::moved, &tracker, &Tracker::onMoved);
+    particles.resize(2);
+    particles.resize(3);
+
+    particles.emitRange(&Particle::moved, 0, 3, &positionOf);
+    S_CHECK(tracker.m_positions.empty());
+}
@@ -0,0 +1,129 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Causalità: l'ID del thread che emette arriva alle slot annidate e a quelle accodate
+
+namespace
+{
+
+class Emitter : public SObject
+{
+public:
+    S_SIGNAL void valueChanged(int) {}
+
+    void fire(int value)
+    {
+        emitSignal(&Emitter::valueChanged, value);
+    }
+};
+
+// Ricorda la causalità vista dall'ultima chiamata
+class Recorder : public SObject
+{
+public:
+    S_SLOT void onValue(int)
+    {
+        m_causality = currentCausality();
+        ++m_calls;
+    }
+
+    std::atomic<std::uint64_t> m_causality{ 0 };
+    std::atomic<unsigned> m_calls{ 0 };
+};
+
+// Slot che emette a sua volta: il secondo salto gira nello stesso thread
+class Relay : public Emitter
+{
+public:
+    S_SLOT void onValue(int value)
+    {
+        fire(value + 1);
+    }
+};
+
+} // namespace
+
+
+
+// =======================================
+//
+//               Causalità
+//
+// =======================================
+
+S_TEST(causalityDefaultsToZeroAndScopesRestore)
+{
+    S_CHECK_EQUAL(currentCausality(), std::uint64_t(0));
+
+    const std::uint64_t outer = newCausality();
+    const std::uint64_t inner = newCausality();
+    S_CHECK(outer != 0);
+    S_CHECK(inner != outer);
+
+    {
+        SCausalityScope outerScope(outer);
+        {
+            SCausalityScope innerScope(inner);
+            S_CHECK_EQUAL(currentCausality(), inner);
+        }
+        S_CHECK_EQUAL(currentCausality(), outer);
+    }
+    S_CHECK_EQUAL(currentCausality(), std::uint64_t(0));
+}
+
+S_TEST(nestedEmitsSeeTheOriginalCausality)
+{
+    Emitter emitter;
+    Relay relay;
+    Recorder recorder;
+    connect(&emitter, &Emitter::valueChanged, &relay, &Relay::onValue);
+    connect(&relay, &Emitter::valueChanged, &recorder, &Recorder::onValue);
+
+    const std::uint64_t id = newCausality();
+    {
+        SCausalityScope scope(id);
+        emitter.fire(1);
+    }
+
+    S_CHECK_EQUAL(recorder.m_calls.load(), 1u);
+    S_CHECK_EQUAL(recorder.m_causality.load(), id);
+}
+
+#ifdef SOBJECT_THREAD_SAFE
+S_TEST(queuedSlotsSeeThePostingCausality)
+{
+    Emitter emitter;
+    Recorder recorder;
+    connect(&emitter, &Emitter::valueChanged, &recorder, &Recorder::onValue, SQueuedConnection);
+
+    SEventLoopPool pool(1, false);
+    pool.assign(&recorder);
+
+    const auto waitCalls = [&recorder](unsigned calls)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while(recorder.m_calls < calls and std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+        return recorder.m_calls == calls;
+    };
+
+    const std::uint64_t id = newCausality();
+    {
+        SCausalityScope scope(id);
+        emitter.fire(1);
+    }
+    S_CHECK(waitCalls(1));
+    S_CHECK_EQUAL(recorder.m_causality.load(), id);
+
+    // Il loop ripristina la propria causalità dopo ogni task
+    emitter.fire(2);
+    S_CHECK(waitCalls(2));
+    S_CHECK_EQUAL(recorder.m_causality.load(), std::uint64_t(0));
+
+    pool.stop();
+}
+#endif
@@ -0,0 +1,273 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#include <string>
+#include <vector>
+
+// Replay, connect single shot, connect unique e gruppi di ordinamento
+
+namespace
+{
+
+class Emitter : public SObject
+{
+public:
+    S_SIGNAL void valueChanged(int) {}
+
+    void fire(int value)
+    {
+        emitSignal(&Emitter::valueChanged, value);
+    }
+
+    void enableReplay(std::size_t depth)
+    {
+        setSignalReplay(&Emitter::valueChanged, depth);
+    }
+};
+
+class Receiver : public SObject
+{
+public:
+    S_SLOT void onValue(int value)
+    {
+        m_values.push_back(value);
+    }
+
+    S_SLOT void onOther(int value)
+    {
+        m_values.push_back(-value);
+    }
+
+    std::vector<int> m_values;
+};
+
+// Registra l'ordine di chiamata delle slot di più receiver
+class Tracer : public SObject
+{
+public:
+    explicit Tracer(std::string* trace, char name) : m_trace(trace), m_name(name) {}
+
+    S_SLOT void onValue(int)
+    {
+        m_trace->push_back(m_name);
+    }
+
+private:
+    std::string* m_trace;
+    char m_name;
+};
+
+} // namespace
+
+
+
+// =======================================
+//
+//               Replay
+//
+// =======================================
+
+S_TEST(replayLastDeliversMostRecentValue)
+{
+    Emitter emitter;
+    emitter.enableReplay(3);
+    emitter.fire(1);
+    emitter.fire(2);
+
+    Receiver receiver;
+    connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SReplayLastConnection);
+    S_CHECK(receiver.m_values == std::vector<int>({ 2 }));
+
+    emitter.fire(3);
+    S_CHECK(receiver.m_values == std::vector<int>({ 2, 3 }));
+}
+
+S_TEST(replayAllDeliversBoundedBuffer)
+{
+    Emitter emitter;
+    emitter.enableReplay(2);
+    emitter.fire(1);
+    emitter.fire(2);
+    emitter.fire(3);
+
+    Receiver receiver;
+    connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SReplayAllConnection);
+    S_CHECK(receiver.m_values == std::vector<int>({ 2, 3 }));
+}
+
+S_TEST(replaySurvivesDisconnect)
+{
+    Emitter emitter;
+    emitter.enableReplay(1);
+
+    Receiver first;
+    connect(&emitter, &Emitter::valueChanged, &first, &Receiver::onValue);
+    emitter.fire(7);
+    disconnect(&emitter, &Emitter::valueChanged);
+
+    Receiver second;
+    connect(&emitter, &Emitter::valueChanged, &second, &Receiver::onValue, SReplayLastConnection);
+    S_CHECK(second.m_values == std::vector<int>({ 7 }));
+}
+
+S_TEST(replayWithoutBufferDeliversNothing)
+{
+    Emitter emitter;
+    emitter.fire(1);
+
+    Receiver receiver;
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SReplayLastConnection));
+    S_CHECK(receiver.m_values.empty());
+}
+
+
+
+// =======================================
+//
+//             Single shot
+//
+// =======================================
+
+S_TEST(singleShotRunsOnce)
+{
+    Emitter emitter;
+    Receiver receiver;
+    connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SSingleShotConnection);
+
+    emitter.fire(1);
+    emitter.fire(2);
+    S_CHECK(receiver.m_values == std::vector<int>({ 1 }));
+    S_CHECK(not emitter.connectedWithObject(&receiver));
+}
+
+S_TEST(singleShotKeepsOtherSlots)
+{
+    Emitter emitter;
+    Receiver once;
+    Receiver always;
+    connect(&emitter, &Emitter::valueChanged, &once, &Receiver::onValue, SSingleShotConnection);
+    connect(&emitter, &Emitter::valueChanged, &always, &Receiver::onValue);
+
+    emitter.fire(1);
+    emitter.fire(2);
+    S_CHECK(once.m_values == std::vector<int>({ 1 }));
+    S_CHECK(always.m_values == std::vector<int>({ 1, 2 }));
+}
+
+S_TEST(singleShotWithReplayFiresImmediately)
+{
+    Emitter emitter;
+    emitter.enableReplay(4);
+    emitter.fire(1);
+    emitter.fire(2);
+
+    Receiver receiver;
+    connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SSingleShotConnection | SReplayAllConnection);
+    emitter.fire(3);
+
+    // Solo l'ultimo valore, poi la connect non esiste più
+    S_CHECK(receiver.m_values == std::vector<int>({ 2 }));
+    S_CHECK(not emitter.connectedWithObject(&receiver));
+}
+
+S_TEST(singleShotReceiverDestroyedBeforeEmit)
+{
+    Emitter emitter;
+    {
+        Receiver receiver;
+        connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SSingleShotConnection);
+    }
+
+    emitter.fire(1);
+    S_CHECK(emitter.getAllReceivers().empty());
+}
+
+
+
+// =======================================
+//
+//               Unique
+//
+// =======================================
+
+S_TEST(uniqueRejectsDuplicate)
+{
+    Emitter emitter;
+    Receiver receiver;
+
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SUniqueConnection));
+    S_CHECK(not connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SUniqueConnection));
+
+    // Un metodo diverso o un receiver diverso non sono duplicati
+    Receiver other;
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onOther, SUniqueConnection));
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &other, &Receiver::onValue, SUniqueConnection));
+
+    emitter.fire(1);
+    S_CHECK(receiver.m_values == std::vector<int>({ 1, -1 }));
+}
+
+S_TEST(uniqueSeesConnectionsMadeBeforeIndex)
+{
+    Emitter emitter;
+    Receiver receiver;
+
+    connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue);
+    S_CHECK(not connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SUniqueConnection));
+}
+
+S_TEST(uniqueAcceptsAfterDisconnect)
+{
+    Emitter emitter;
+    Receiver receiver;
+
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SUniqueConnection));
+    disconnect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue);
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SUniqueConnection));
+
+    emitter.fire(1);
+    S_CHECK(receiver.m_values == std::vector<int>({ 1 }));
+}
+
+
+
+// =======================================
+//
+//               Gruppi
+//
+// =======================================
+
+S_TEST(groupsRunPreDefaultPost)
+{
+    std::string trace;
+    Tracer a(&trace, 'a'), b(&trace, 'b'), c(&trace, 'c'), d(&trace, 'd'), e(&trace, 'e');
+
+    Emitter emitter;
+    connect(&emitter, &Emitter::valueChanged, &a, &Tracer::onValue, SPostConnection);
+    connect(&emitter, &Emitter::valueChanged, &b, &Tracer::onValue);
+    connect(&emitter, &Emitter::valueChanged, &c, &Tracer::onValue, SPreConnection);
+    connect(&emitter, &Emitter::valueChanged, &d, &Tracer::onValue);
+    connect(&emitter, &Emitter::valueChanged, &e, &Tracer::onValue, SPreConnection);
+
+    emitter.fire(0);
+    S_CHECK_EQUAL(trace, std::string("cebda"));
+}
+
+S_TEST(groupsKeepOrderAfterDisconnect)
+{
+    std::string trace;
+    Tracer a(&trace, 'a'), b(&trace, 'b'), c(&trace, 'c');
+
+    Emitter emitter;
+    connect(&emitter, &Emitter::valueChanged, &a, &Tracer::onValue, SPreConnection);
+    connect(&emitter, &Emitter::valueChanged, &b, &Tracer::onValue, SPostConnection);
+    disconnect(&emitter, &Emitter::valueChanged, &a);
+
+    // Il gruppo pre è vuoto: la nuova slot va comunque prima di quelle post
+    connect(&emitter, &Emitter::valueChanged, &c, &Tracer::onValue);
+    connect(&emitter, &Emitter::valueChanged, &a, &Tracer::onValue, SPreConnection);
+
+    emitter.fire(0);
+    S_CHECK_EQUAL(trace, std::string("acb"));
+}
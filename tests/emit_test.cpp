@@ -0,0 +1,243 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Slot chiamate da un emit: stesse regole in tutte le modalità (lista, programma compilato, snapshot)
+
+namespace
+{
+
+class Emitter : public SObject
+{
+public:
+    S_SIGNAL void valueChanged(int) {}
+
+    void fire(int value)
+    {
+        emitSignal(&Emitter::valueChanged, value);
+    }
+
+    void enableFlow()
+    {
+        setSignalFlow(&Emitter::valueChanged);
+    }
+};
+
+class TextEmitter : public SObject
+{
+public:
+    S_SIGNAL void textChanged(std::string) {}
+
+    void fire(const std::string& text)
+    {
+        emitSignal(&TextEmitter::textChanged, text);
+    }
+
+    void enableFlow()
+    {
+        setSignalFlow(&TextEmitter::textChanged);
+    }
+};
+
+// Slot per valore: il parametro viene costruito spostando quello inoltrato dall'emit
+class TextReceiver : public SObject
+{
+public:
+    S_SLOT void onText(std::string text)
+    {
+        m_texts.push_back(std::move(text));
+    }
+
+    std::vector<std::string> m_texts;
+};
+
+class Receiver : public SObject
+{
+public:
+    S_SLOT void onValue(int value)
+    {
+        m_values.push_back(value);
+    }
+
+    std::vector<int> m_values;
+};
+
+// A ogni emit connette un nuovo receiver al segnale che lo ha chiamato
+class Spawner : public SObject
+{
+public:
+    Spawner(Emitter* emitter, SConnectionType type) : m_emitter(emitter), m_type(type) {}
+
+    S_SLOT void onValue(int value)
+    {
+        m_spawned.emplace_back(new Receiver);
+        connect(m_emitter, &Emitter::valueChanged, m_spawned.back().get(), &Receiver::onValue, m_type);
+        m_values.push_back(value);
+    }
+
+    std::vector<std::unique_ptr<Receiver>> m_spawned;
+    std::vector<int> m_values;
+
+private:
+    Emitter* m_emitter;
+    SConnectionType m_type;
+};
+
+std::vector<int> spawnedValues(const Spawner& spawner)
+{
+    std::vector<int> values;
+    for(const std::unique_ptr<Receiver>& receiver : spawner.m_spawned) values.insert(values.end(), receiver->m_values.begin(), receiver->m_values.end());
+    return values;
+}
+
+} // namespace
+
+
+
+// =======================================
+//
+//        Connect durante l'emit
+//
+// =======================================
+
+S_TEST(connectDuringEmitIsNotCalledByIt)
+{
+    Emitter emitter;
+    Spawner spawner(&emitter, SDefaultConnection);
+    connect(&emitter, &Emitter::valueChanged, &spawner, &Spawner::onValue);
+
+    emitter.fire(5);
+    S_CHECK(spawnedValues(spawner).empty());
+
+    // Il primo receiver riceve solo il secondo emit
+    emitter.fire(6);
+    S_CHECK(spawnedValues(spawner) == std::vector<int>({ 6 }));
+}
+
+S_TEST(singleShotConnectDuringEmitIsNotCalledByIt)
+{
+    // Le slot single shot portano il segnale sull'emit con il lock anche con SOBJECT_SEQLOCK_EMIT:
+    // la regola non deve dipendere dal percorso dell'emit
+    Emitter emitter;
+    Spawner spawner(&emitter, SSingleShotConnection);
+    connect(&emitter, &Emitter::valueChanged, &spawner, &Spawner::onValue);
+
+    emitter.fire(5);
+    emitter.fire(6);
+    emitter.fire(7);
+    S_CHECK(spawner.m_values == std::vector<int>({ 5, 6, 7 }));
+    S_CHECK(spawnedValues(spawner) == std::vector<int>({ 6, 7 }));
+}
+
+S_TEST(groupedConnectDuringEmitIsNotCalledByIt)
+{
+    // Una slot pre connette una slot post, che nella lista sta dopo la posizione dell'emit
+    Emitter emitter;
+    Spawner spawner(&emitter, SPostConnection);
+    connect(&emitter, &Emitter::valueChanged, &spawner, &Spawner::onValue, SPreConnection);
+
+    emitter.fire(1);
+    S_CHECK(spawnedValues(spawner).empty());
+
+    emitter.fire(2);
+    S_CHECK(spawnedValues(spawner) == std::vector<int>({ 2 }));
+}
+
+S_TEST(connectDuringCompiledEmitIsNotCalledByIt)
+{
+    // Con il programma compilato la connect lo invalida e l'emit prosegue sulla lista
+    Emitter emitter;
+    emitter.enableFlow();
+    Receiver before;
+    Spawner spawner(&emitter, SDefaultConnection);
+    Receiver after;
+    connect(&emitter, &Emitter::valueChanged, &before, &Receiver::onValue);
+    connect(&emitter, &Emitter::valueChanged, &spawner, &Spawner::onValue);
+    connect(&emitter, &Emitter::valueChanged, &after, &Receiver::onValue);
+
+    emitter.fire(1);
+    emitter.fire(2);
+    S_CHECK(before.m_values == std::vector<int>({ 1, 2 }));
+    S_CHECK(after.m_values == std::vector<int>({ 1, 2 }));
+    S_CHECK(spawnedValues(spawner) == std::vector<int>({ 2 }));
+}
+
+
+
+// =======================================
+//
+//        Parametri per valore
+//
+// =======================================
+
+S_TEST(byValueArgumentReachesEverySlot)
+{
+    TextEmitter emitter;
+    TextReceiver first, second, third;
+    connect(&emitter, &TextEmitter::textChanged, &first, &TextReceiver::onText);
+    connect(&emitter, &TextEmitter::textChanged, &second, &TextReceiver::onText);
+    connect(&emitter, &TextEmitter::textChanged, &third, &TextReceiver::onText, SPreConnection);
+
+    emitter.fire("x1");
+    emitter.fire("x2");
+
+    const std::vector<std::string> expected({ "x1", "x2" });
+    S_CHECK(first.m_texts == expected);
+    S_CHECK(second.m_texts == expected);
+    S_CHECK(third.m_texts == expected);
+}
+
+S_TEST(byValueArgumentReachesEverySlotOfCompiledProgram)
+{
+    TextEmitter emitter;
+    emitter.enableFlow();
+    TextReceiver first, second;
+    connect(&emitter, &TextEmitter::textChanged, &first, &TextReceiver::onText);
+    connect(&emitter, &TextEmitter::textChanged, &second, &TextReceiver::onText);
+
+    emitter.fire("x1");
+    emitter.fire("x2");
+    emitter.fire("x3");
+
+    const std::vector<std::string> expected({ "x1", "x2", "x3" });
+    S_CHECK(first.m_texts == expected);
+    S_CHECK(second.m_texts == expected);
+}
+
+S_TEST(byValueArgumentReachesEverySlotWithSingleShot)
+{
+    TextEmitter emitter;
+    TextReceiver once, first, last;
+    connect(&emitter, &TextEmitter::textChanged, &first, &TextReceiver::onText);
+    connect(&emitter, &TextEmitter::textChanged, &last, &TextReceiver::onText);
+    connect(&emitter, &TextEmitter::textChanged, &once, &TextReceiver::onText, SSingleShotConnection | SPreConnection);
+
+    emitter.fire("x1");
+    emitter.fire("x2");
+
+    S_CHECK(once.m_texts == std::vector<std::string>({ "x1" }));
+    S_CHECK(first.m_texts == std::vector<std::string>({ "x1", "x2" }));
+    S_CHECK(last.m_texts == std::vector<std::string>({ "x1", "x2" }));
+}
+
+S_TEST(byValueArgumentReachesEverySlotAfterDisconnect)
+{
+    // Slot rimosse dallo snapshot (o dalla lista) prima e dopo le slot chiamate
+    TextEmitter emitter;
+    std::vector<TextReceiver> receivers(128);
+    for(TextReceiver& receiver : receivers) connect(&emitter, &TextEmitter::textChanged, &receiver, &TextReceiver::onText);
+
+    disconnect(&emitter, &TextEmitter::textChanged, &receivers[0]);
+    disconnect(&emitter, &TextEmitter::textChanged, &receivers[127]);
+    emitter.fire("x1");
+
+    const std::size_t delivered = std::count_if(receivers.begin() + 1, receivers.end() - 1, [](const TextReceiver& receiver) { return receiver.m_texts == std::vector<std::string>({ "x1" }); });
+    S_CHECK_EQUAL(delivered, std::size_t(126));
+    S_CHECK(receivers[0].m_texts.empty());
+    S_CHECK(receivers[127].m_texts.empty());
+}
@@ -0,0 +1,179 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#include <limits>
+
+// Filtri delle connect: limite di chiamate e campionamento
+
+namespace
+{
+
+class Emitter : public SObject
+{
+public:
+    S_SIGNAL void valueChanged(int) {}
+
+    void fire(int value)
+    {
+        emitSignal(&Emitter::valueChanged, value);
+    }
+
+    void fireMany(int count)
+    {
+        for(int i = 0; i < count; ++i) fire(i);
+    }
+};
+
+class Receiver : public SObject
+{
+public:
+    S_SLOT void onValue(int)
+    {
+        ++m_calls;
+    }
+
+    int m_calls = 0;
+};
+
+} // namespace
+
+
+
+// =======================================
+//
+//           Limite di chiamate
+//
+// =======================================
+
+S_TEST(rateLimitAllowsBurstThenDrops)
+{
+    Emitter emitter;
+    Receiver receiver;
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SRateLimit{1, 3}));
+
+    emitter.fireMany(10);
+    S_CHECK_EQUAL(receiver.m_calls, 3);
+    S_CHECK_EQUAL(droppedCount(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue), std::uint64_t(7));
+}
+
+S_TEST(rateLimitKeepsOtherConnections)
+{
+    Emitter emitter;
+    Receiver limited, unlimited;
+    connect(&emitter, &Emitter::valueChanged, &limited, &Receiver::onValue, SRateLimit{1, 1});
+    connect(&emitter, &Emitter::valueChanged, &unlimited, &Receiver::onValue);
+
+    emitter.fireMany(5);
+    S_CHECK_EQUAL(limited.m_calls, 1);
+    S_CHECK_EQUAL(unlimited.m_calls, 5);
+}
+
+S_TEST(rateLimitRejectsInvalidLimits)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    Emitter emitter;
+    Receiver receiver;
+    S_CHECK(not connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SRateLimit{0, 0}));
+    S_CHECK(not connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SRateLimit{-5, 10}));
+    S_CHECK(not connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SRateLimit{10, 0.5}));
+    S_CHECK(not connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SRateLimit{nan, 1}));
+    S_CHECK(not connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SRateLimit{1, nan}));
+
+    emitter.fireMany(3);
+    S_CHECK_EQUAL(receiver.m_calls, 0);
+    S_CHECK(not emitter.connectedWithObject(&receiver));
+}
+
+S_TEST(rateLimitSaturatesExtremeLimits)
+{
+    Emitter emitter;
+    Receiver bursty, slow;
+
+    // Una raffica enorme non limita nulla, un limite minuscolo lascia passare solo la prima chiamata
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &bursty, &Receiver::onValue, SRateLimit{1, 1e300}));
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &slow, &Receiver::onValue, SRateLimit{1e-300, 1}));
+
+    emitter.fireMany(10);
+    S_CHECK_EQUAL(bursty.m_calls, 10);
+    S_CHECK_EQUAL(slow.m_calls, 1);
+}
+
+
+
+// =======================================
+//
+//             Campionamento
+//
+// =======================================
+
+S_TEST(samplingTakesEveryNthEmit)
+{
+    Emitter emitter;
+    Receiver receiver;
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SSampling{4, false}));
+
+    emitter.fireMany(40);
+    S_CHECK_EQUAL(receiver.m_calls, 10);
+}
+
+S_TEST(randomSamplingTakesOneInNOnAverage)
+{
+    Emitter emitter;
+    Receiver receiver;
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SSampling{10, true}));
+
+    emitter.fireMany(10000);
+    S_CHECK(receiver.m_calls > 500);
+    S_CHECK(receiver.m_calls < 1500);
+}
+
+
+
+// =======================================
+//
+//           Opzioni combinate
+//
+// =======================================
+
+S_TEST(optionsCombineModuleLimitAndSampling)
+{
+    Emitter emitter;
+    Receiver receiver;
+    SModuleToken module;
+
+    // Il campionamento lascia passare 5 emit su 10, il limite ne accetta 2
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue,
+                    SConnectOptions().module(module).rateLimit({1, 2}).sampling({2, false})));
+
+    emitter.fireMany(10);
+    S_CHECK_EQUAL(receiver.m_calls, 2);
+    S_CHECK_EQUAL(droppedCount(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue), std::uint64_t(3));
+
+    // La connect appartiene comunque al modulo
+    disconnectModule(module);
+    S_CHECK(not emitter.connectedWithObject(&receiver));
+}
+
+S_TEST(optionsKeepConnectionType)
+{
+    Emitter emitter;
+    Receiver receiver;
+
+    S_CHECK(connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SConnectOptions(SUniqueConnection).sampling({2, false})));
+    S_CHECK(not connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SConnectOptions(SUniqueConnection).rateLimit({1, 1})));
+
+    emitter.fireMany(4);
+    S_CHECK_EQUAL(receiver.m_calls, 2);
+}
+
+S_TEST(optionsRejectInvalidLimit)
+{
+    Emitter emitter;
+    Receiver receiver;
+    SModuleToken module;
+
+    S_CHECK(not connect(&emitter, &Emitter::valueChanged, &receiver, &Receiver::onValue, SConnectOptions().module(module).rateLimit({0, 1})));
+    S_CHECK(not emitter.connectedWithObject(&receiver));
+}
@@ -0,0 +1,161 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#include <vector>
+
+// Grafi statici: slot legate a tempo di compilazione e chiamate prima di quelle connesse a runtime
+
+namespace
+{
+
+struct Pipeline;
+
+class Source : public SObject
+{
+public:
+    typedef Pipeline SStaticWiring;
+
+    S_SIGNAL void valueChanged(int) {}
+    S_SIGNAL void reset() {}
+
+    void fire(int value)
+    {
+        emitSignal(&Source::valueChanged, value);
+    }
+
+    void fireReset()
+    {
+        emitSignal(&Source::reset);
+    }
+};
+
+// Ogni chiamata scrive l'identificativo della slot nel registro condiviso
+class Stage : public SObject
+{
+public:
+    Stage(std::vector<int>* log, int id) : m_log(log), m_id(id) {}
+
+    S_SLOT void onValue(int value)
+    {
+        record(m_id);
+        m_last = value;
+    }
+
+    int m_last = 0;
+
+protected:
+    void record(int id)
+    {
+        m_log->push_back(id);
+    }
+
+    std::vector<int>* m_log;
+    int m_id;
+};
+
+// Le classi del grafo dichiarano le proprie slot: il grafo cerca i receiver per tipo
+class Filter : public Stage
+{
+public:
+    Filter(std::vector<int>* log) : Stage(log, 1) {}
+
+    S_SLOT void onValue(int value)
+    {
+        Stage::onValue(value);
+    }
+};
+
+class Sink : public Stage
+{
+public:
+    Sink(std::vector<int>* log) : Stage(log, 2) {}
+
+    S_SLOT void onValue(int value)
+    {
+        Stage::onValue(value);
+    }
+
+    S_SLOT void onReset()
+    {
+        record(-m_id);
+    }
+};
+
+struct Pipeline : SStaticGraph<S_CONN(&Source::valueChanged, &Filter::onValue),
+                               S_CONN(&Source::valueChanged, &Sink::onValue),
+                               S_CONN(&Source::reset, &Sink::onReset)>
+{
+    using SStaticGraph::SStaticGraph;
+};
+
+} // namespace
+
+
+
+// =======================================
+//
+//             Grafi statici
+//
+// =======================================
+
+S_TEST(staticSlotsRunInDeclarationOrderBeforeRuntimeSlots)
+{
+    std::vector<int> log;
+    Source source;
+    Filter filter(&log);
+    Sink sink(&log);
+    Stage runtime(&log, 3);
+
+    Pipeline pipeline(&source, &filter, &sink);
+    connect(&source, &Source::valueChanged, &runtime, &Stage::onValue);
+
+    source.fire(7);
+    S_CHECK(log == std::vector<int>({ 1, 2, 3 }));
+    S_CHECK_EQUAL(filter.m_last, 7);
+    S_CHECK_EQUAL(sink.m_last, 7);
+}
+
+S_TEST(staticGraphDispatchesOnlyTheEmittedSignal)
+{
+    std::vector<int> log;
+    Source source;
+    Filter filter(&log);
+    Sink sink(&log);
+    Pipeline pipeline(&source, &filter, &sink);
+
+    source.fireReset();
+    S_CHECK(log == std::vector<int>({ -2 }));
+}
+
+S_TEST(destroyedGraphIsNoLongerCalled)
+{
+    std::vector<int> log;
+    Source source;
+    Filter filter(&log);
+    Sink sink(&log);
+    Stage runtime(&log, 3);
+    connect(&source, &Source::valueChanged, &runtime, &Stage::onValue);
+
+    {
+        Pipeline pipeline(&source, &filter, &sink);
+    }
+
+    source.fire(1);
+    S_CHECK(log == std::vector<int>({ 3 }));
+}
+
+S_TEST(emitterDestroyedBeforeGraph)
+{
+    std::vector<int> log;
+    Filter filter(&log);
+    Sink sink(&log);
+
+    // Il grafo non deve più scollegare l'emitter distrutto
+    Source* source = new Source;
+    Pipeline pipeline(source, &filter, &sink);
+    source->fire(1);
+    delete source;
+
+    S_CHECK(log == std::vector<int>({ 1, 2 }));
+}
@@ -0,0 +1,199 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#include <future>
+#include <stdexcept>
+#include <string>
+
+// invoke e SFuture: risultato, continuazioni, eccezioni del metodo e future non validi
+
+namespace
+{
+
+class Account : public SObject
+{
+public:
+    int balance(int bonus) const
+    {
+        return m_balance + bonus;
+    }
+
+    void deposit(int amount)
+    {
+        m_balance += amount;
+    }
+
+    int boom(int)
+    {
+        throw std::runtime_error("boom");
+    }
+
+    void boomVoid()
+    {
+        throw std::runtime_error("boom");
+    }
+
+    int m_balance = 10;
+};
+
+bool throwsRuntimeError(SFuture<int>& future)
+{
+    try
+    {
+        future.get();
+    }
+    catch(const std::runtime_error& error)
+    {
+        return std::string(error.what()) == "boom";
+    }
+
+    return false;
+}
+
+bool throwsNoState(SFuture<int>& future)
+{
+    try
+    {
+        future.get();
+    }
+    catch(const std::future_error& error)
+    {
+        return error.code() == std::future_errc::no_state;
+    }
+
+    return false;
+}
+
+} // namespace
+
+
+
+// =======================================
+//
+//             Invoke diretta
+//
+// =======================================
+
+S_TEST(invokeWithoutShardIsReady)
+{
+    Account account;
+    SFuture<int> future = invoke(&account, &Account::balance, 5);
+
+    S_CHECK(future.isValid());
+    S_CHECK(future.isReady());
+    S_CHECK(not future.isCancelled());
+    S_CHECK_EQUAL(future.get(), 15);
+}
+
+S_TEST(invokeThenRunsWithValue)
+{
+    Account account;
+    int seen = 0;
+    SFuture<int> future = invoke(&account, &Account::balance, 1);
+    future.then([&seen](int value) { seen = value; });
+
+    S_CHECK_EQUAL(seen, 11);
+    S_CHECK(not future.isValid());
+}
+
+S_TEST(invokeDirectExceptionReachesGet)
+{
+    // Il metodo lancia: l'eccezione non esce da invoke, la rilancia get()
+    Account account;
+    for(int i = 0; i < 3; ++i)
+    {
+        SFuture<int> future = invoke(&account, &Account::boom, 5);
+        S_CHECK(future.isReady());
+        S_CHECK(throwsRuntimeError(future));
+    }
+
+    SFuture<void> done = invoke(&account, &Account::boomVoid);
+    bool thrown = false;
+    try
+    {
+        done.get();
+    }
+    catch(const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    S_CHECK(thrown);
+
+    // Lo stato restituito al pool torna pulito
+    SFuture<int> next = invoke(&account, &Account::balance, 0);
+    S_CHECK_EQUAL(next.get(), 10);
+}
+
+S_TEST(invokeExceptionSkipsThen)
+{
+    Account account;
+    bool called = false;
+    invoke(&account, &Account::boom, 5).then([&called](int) { called = true; });
+    S_CHECK(not called);
+}
+
+
+
+// =======================================
+//
+//            Future non valido
+//
+// =======================================
+
+S_TEST(invalidFutureIsWellDefined)
+{
+    SFuture<int> empty;
+    S_CHECK(not empty.isValid());
+    S_CHECK(not empty.isReady());
+    S_CHECK(not empty.isCancelled());
+    S_CHECK(throwsNoState(empty));
+
+    // Un future già passato a then() non ha più lo stato
+    Account account;
+    SFuture<int> future = invoke(&account, &Account::balance, 0);
+    future.then([](int) {});
+    S_CHECK(not future.isReady());
+    S_CHECK(throwsNoState(future));
+}
+
+
+
+#ifdef SOBJECT_THREAD_SAFE
+
+// =======================================
+//
+//            Invoke accodata
+//
+// =======================================
+
+S_TEST(invokeRunsOnReceiverShard)
+{
+    Account account;
+    SEventLoopPool pool(1, false);
+    pool.assign(&account);
+
+    invoke(&account, &Account::deposit, 5).get();
+    SFuture<int> future = invoke(&account, &Account::balance, 1);
+    S_CHECK_EQUAL(future.get(), 16);
+
+    pool.release(&account);
+}
+
+S_TEST(invokeQueuedExceptionReachesGet)
+{
+    // Il metodo lancia nel thread del loop: il loop sopravvive e l'eccezione arriva al future
+    Account account;
+    SEventLoopPool pool(1, false);
+    pool.assign(&account);
+
+    SFuture<int> failed = invoke(&account, &Account::boom, 5);
+    S_CHECK(throwsRuntimeError(failed));
+
+    SFuture<int> next = invoke(&account, &Account::balance, 0);
+    S_CHECK_EQUAL(next.get(), 10);
+
+    pool.release(&account);
+}
+
+#endif // SOBJECT_THREAD_SAFE
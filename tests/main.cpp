@@ -0,0 +1,25 @@
+#include "stest.h"
+
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : "";
+    unsigned failed = 0;
+    unsigned run = 0;
+
+    for(const _stest::Test& test : _stest::tests())
+    {
+        if(std::strstr(test.name, filter) == nullptr) continue;
+
+        _stest::failures() = 0;
+        test.function();
+        ++run;
+
+        std::cout << (_stest::failures() == 0 ? "[ OK ] " : "[FAIL] ") << test.name << std::endl;
+        if(_stest::failures() != 0) ++failed;
+    }
+
+    std::cout << run - failed << "/" << run << " test superati" << std::endl;
+    return failed == 0 and run != 0 ? 0 : 1;
+}
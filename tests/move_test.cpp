@@ -0,0 +1,125 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#include <utility>
+#include <vector>
+
+// Spostamento degli SObject: le connect seguono l'oggetto al nuovo indirizzo
+
+namespace
+{
+
+class Emitter : public SObject
+{
+public:
+    S_SIGNAL void valueChanged(int) {}
+
+    void fire(int value)
+    {
+        emitSignal(&Emitter::valueChanged, value);
+    }
+};
+
+class Receiver : public SObject
+{
+public:
+    S_SLOT void onValue(int value)
+    {
+        m_sum += value;
+        ++m_calls;
+    }
+
+    int m_sum   = 0;
+    int m_calls = 0;
+};
+
+} // namespace
+
+
+
+// =======================================
+//
+//              Spostamento
+//
+// =======================================
+
+S_TEST(movedReceiverKeepsItsConnections)
+{
+    Emitter emitter;
+    std::vector<Receiver> receivers(2);
+    connect(&emitter, &Emitter::valueChanged, &receivers[0], &Receiver::onValue);
+
+    // La riallocazione sposta i receiver: la connect segue receivers[0]
+    receivers.reserve(64);
+    emitter.fire(5);
+
+    S_CHECK_EQUAL(receivers[0].m_sum, 5);
+    S_CHECK_EQUAL(receivers[1].m_calls, 0);
+    S_CHECK(emitter.connectedWithObject(&receivers[0]));
+}
+
+S_TEST(movedEmitterKeepsItsConnections)
+{
+    Receiver receiver;
+    Emitter source;
+    connect(&source, &Emitter::valueChanged, &receiver, &Receiver::onValue);
+
+    Emitter moved(std::move(source));
+    moved.fire(3);
+    S_CHECK_EQUAL(receiver.m_sum, 3);
+
+    // L'oggetto spostato resta vuoto
+    source.fire(4);
+    S_CHECK_EQUAL(receiver.m_calls, 1);
+    S_CHECK(not source.connectedWithObject(&receiver));
+    S_CHECK(moved.connectedWithObject(&receiver));
+}
+
+S_TEST(moveAssignmentReplacesConnections)
+{
+    Emitter first, second;
+    Receiver replaced, taken;
+    connect(&first, &Emitter::valueChanged, &replaced, &Receiver::onValue);
+    connect(&second, &Emitter::valueChanged, &taken, &Receiver::onValue);
+
+    // first perde le sue connect e prende quelle di second
+    first = std::move(second);
+    first.fire(1);
+    second.fire(1);
+
+    S_CHECK_EQUAL(replaced.m_calls, 0);
+    S_CHECK_EQUAL(taken.m_calls, 1);
+}
+
+S_TEST(destroyingMovedReceiverDisconnects)
+{
+    Emitter emitter;
+    Receiver other;
+    connect(&emitter, &Emitter::valueChanged, &other, &Receiver::onValue);
+
+    {
+        Receiver source;
+        connect(&emitter, &Emitter::valueChanged, &source, &Receiver::onValue);
+        Receiver moved(std::move(source));
+    }
+
+    // Nessuna delle due copie è ancora connessa
+    emitter.fire(1);
+    S_CHECK_EQUAL(other.m_calls, 1);
+}
+
+#ifdef SOBJECT_THREAD_SAFE
+S_TEST(movedReceiverKeepsItsShard)
+{
+    SEventLoopPool pool(2, false);
+    Receiver source;
+    pool.assign(&source, 1);
+
+    Receiver moved(std::move(source));
+    S_CHECK_EQUAL(pool.shardOf(&moved), std::size_t(1));
+    S_CHECK_EQUAL(pool.shardOf(&source), pool.size());
+
+    pool.stop();
+}
+#endif
@@ -0,0 +1,138 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#include <vector>
+
+// Prefab: le connect interne a un gruppo di oggetti replicate su nuovi gruppi
+
+namespace
+{
+
+class Sensor : public SObject
+{
+public:
+    S_SIGNAL void measured(int) {}
+
+    void fire(int value)
+    {
+        emitSignal(&Sensor::measured, value);
+    }
+};
+
+// Ogni chiamata scrive l'identificativo dell'oggetto nel registro condiviso
+class Stage : public SObject
+{
+public:
+    Stage(std::vector<int>* log, int id) : m_log(log), m_id(id) {}
+
+    S_SLOT void onValue(int)
+    {
+        m_log->push_back(m_id);
+        ++m_calls;
+    }
+
+    int m_calls = 0;
+
+private:
+    std::vector<int>* m_log;
+    int m_id;
+};
+
+class Filter : public Stage
+{
+public:
+    using Stage::Stage;
+
+    S_SLOT void onValue(int value)
+    {
+        Stage::onValue(value);
+    }
+};
+
+class Logger : public Stage
+{
+public:
+    using Stage::Stage;
+
+    S_SLOT void onValue(int value)
+    {
+        Stage::onValue(value);
+    }
+};
+
+} // namespace
+
+
+
+// =======================================
+//
+//                Prefab
+//
+// =======================================
+
+S_TEST(prefabCapturesOnlyInternalConnections)
+{
+    std::vector<int> log;
+    Sensor sensor;
+    Filter filter(&log, 1);
+    Stage outsider(&log, 9);
+    connect(&sensor, &Sensor::measured, &filter, &Filter::onValue);
+    connect(&sensor, &Sensor::measured, &outsider, &Stage::onValue);
+
+    SPrefab<Sensor, Filter> prefab(&sensor, &filter);
+    S_CHECK_EQUAL(prefab.connectionCount(), std::size_t(1));
+
+    Sensor sensor2;
+    Filter filter2(&log, 2);
+    prefab.instantiate(&sensor2, &filter2);
+
+    sensor2.fire(1);
+    S_CHECK(log == std::vector<int>({ 2 }));
+    S_CHECK_EQUAL(outsider.m_calls, 0);
+}
+
+S_TEST(prefabKeepsConnectionTypesAndOrder)
+{
+    std::vector<int> log;
+    Sensor sensor;
+    Filter filter(&log, 1);
+    Logger logger(&log, 2);
+    connect(&sensor, &Sensor::measured, &filter, &Filter::onValue, SPostConnection);
+    connect(&sensor, &Sensor::measured, &logger, &Logger::onValue, SPreConnection);
+
+    SPrefab<Sensor, Filter, Logger> prefab(&sensor, &filter, &logger);
+
+    Sensor sensor2;
+    Filter filter2(&log, 3);
+    Logger logger2(&log, 4);
+    prefab.instantiate(&sensor2, &filter2, &logger2);
+
+    // Il logger pre viene chiamato prima del filtro post, come nel modello
+    sensor2.fire(1);
+    S_CHECK(log == std::vector<int>({ 4, 3 }));
+}
+
+S_TEST(prefabKeepsSamplingAndOutlivesTemplate)
+{
+    std::vector<int> log;
+    SPrefab<Sensor, Filter>* prefab = nullptr;
+    {
+        Sensor sensor;
+        Filter filter(&log, 1);
+        connect(&sensor, &Sensor::measured, &filter, &Filter::onValue, SSampling{2, false});
+        prefab = new SPrefab<Sensor, Filter>(&sensor, &filter);
+    }
+
+    // Ogni istanza ha il proprio contatore di campionamento
+    Sensor first, second;
+    Filter firstFilter(&log, 2), secondFilter(&log, 3);
+    prefab->instantiate(&first, &firstFilter);
+    prefab->instantiate(&second, &secondFilter);
+    delete prefab;
+
+    for(int i = 0; i < 4; ++i) first.fire(i);
+    second.fire(0);
+    S_CHECK_EQUAL(firstFilter.m_calls, 2);
+    S_CHECK_EQUAL(secondFilter.m_calls, 0);
+}
@@ -0,0 +1,207 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#ifdef SOBJECT_THREAD_SAFE
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// SSlotScheduler: slot di un emit eseguite in parallelo quando le loro risorse non sono in conflitto
+
+namespace
+{
+
+class Grid : public SObject
+{
+public:
+    S_SIGNAL void stepped(int) {}
+    S_SIGNAL void named(std::string) {}
+};
+
+// Stato condiviso dalle slot di un test: ordine delle chiamate e slot in esecuzione nello stesso momento
+struct Probe
+{
+    void enter(int id)
+    {
+        if(++m_active > 1) m_overlapped = true;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_order.push_back(id);
+    }
+
+    void leave()
+    {
+        --m_active;
+    }
+
+    std::vector<int> order()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_order;
+    }
+
+    std::atomic<int> m_active{ 0 };
+    std::atomic<int> m_entered{ 0 };
+    std::atomic<bool> m_overlapped{ false };
+
+private:
+    std::mutex m_mutex;
+    std::vector<int> m_order;
+};
+
+class Cell : public SObject
+{
+public:
+    Cell(Probe* probe, int id) : m_probe(probe), m_id(id) {}
+
+    // Resta in esecuzione per un po' perché un'eventuale sovrapposizione venga vista
+    S_SLOT void update(int value)
+    {
+        m_probe->enter(m_id * 100 + value);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        m_probe->leave();
+    }
+
+    // Aspetta che entrambe le slot siano entrate: riesce solo se vengono eseguite insieme
+    S_SLOT void meet(int)
+    {
+        ++m_probe->m_entered;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while(m_probe->m_entered < 2 and std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+        m_met = m_probe->m_entered >= 2;
+    }
+
+    S_SLOT void rename(std::string name)
+    {
+        m_name = name;
+        name.clear();
+    }
+
+    S_SLOT void evict(int)
+    {
+        update(0);
+        disconnect(m_grid, &Grid::stepped, m_victim);
+    }
+
+    Probe* const m_probe;
+    const int m_id;
+    std::atomic<bool> m_met{ false };
+    std::string m_name;
+    Grid* m_grid  = nullptr;
+    Cell* m_victim = nullptr;
+};
+
+} // namespace
+
+
+
+// =======================================
+//
+//             Slot scheduler
+//
+// =======================================
+
+S_TEST(schedulerRunsIndependentSlotsTogether)
+{
+    Probe probe;
+    Grid grid;
+    Cell heat(&probe, 1), flow(&probe, 2);
+    connect(&grid, &Grid::stepped, &heat, &Cell::meet, SAccess().read(&grid).write(&heat));
+    connect(&grid, &Grid::stepped, &flow, &Cell::meet, SAccess().read(&grid).write(&flow));
+
+    SSlotScheduler scheduler(2);
+    scheduler.emit(&grid, &Grid::stepped, 1);
+
+    S_CHECK(heat.m_met.load());
+    S_CHECK(flow.m_met.load());
+}
+
+S_TEST(schedulerSerializesConflictingSlotsInEmitOrder)
+{
+    Probe probe;
+    Grid grid;
+    Cell first(&probe, 1), second(&probe, 2), third(&probe, 3);
+    int shared = 0;
+
+    // Scrivono la stessa risorsa (la terza la legge soltanto)
+    connect(&grid, &Grid::stepped, &first, &Cell::update, SAccess().write(&shared));
+    connect(&grid, &Grid::stepped, &second, &Cell::update, SAccess().write(&shared));
+    connect(&grid, &Grid::stepped, &third, &Cell::update, SAccess().read(&shared));
+
+    SSlotScheduler scheduler(2);
+    scheduler.emit(&grid, &Grid::stepped, 1);
+
+    S_CHECK(not probe.m_overlapped);
+    S_CHECK(probe.order() == std::vector<int>({ 101, 201, 301 }));
+}
+
+S_TEST(schedulerSerializesSlotsWithoutAccess)
+{
+    Probe probe;
+    Grid grid;
+    Cell declared(&probe, 1), undeclared(&probe, 2);
+    connect(&grid, &Grid::stepped, &declared, &Cell::update, SAccess().write(&declared));
+    connect(&grid, &Grid::stepped, &undeclared, &Cell::update);
+
+    SSlotScheduler scheduler(2);
+    scheduler.emit(&grid, &Grid::stepped, 1);
+
+    S_CHECK(not probe.m_overlapped);
+    S_CHECK_EQUAL(probe.order().size(), std::size_t(2));
+}
+
+S_TEST(schedulerRunsPostedEmitsInOrder)
+{
+    Probe probe;
+    Grid grid;
+    Cell cell(&probe, 1);
+    connect(&grid, &Grid::stepped, &cell, &Cell::update, SAccess().write(&cell));
+
+    SSlotScheduler scheduler(2);
+    scheduler.post(&grid, &Grid::stepped, 1);
+    scheduler.post(&grid, &Grid::stepped, 2);
+    scheduler.post(&grid, &Grid::stepped, 3);
+    scheduler.run();
+
+    S_CHECK(probe.order() == std::vector<int>({ 101, 102, 103 }));
+}
+
+S_TEST(schedulerSkipsSlotDisconnectedBeforeItsTurn)
+{
+    Probe probe;
+    Grid grid;
+    Cell evictor(&probe, 1), victim(&probe, 2);
+    evictor.m_grid   = &grid;
+    evictor.m_victim = &victim;
+
+    // La vittima dipende dall'evictor, che la disconnette prima che arrivi il suo turno
+    connect(&grid, &Grid::stepped, &evictor, &Cell::evict, SAccess().write(&victim));
+    connect(&grid, &Grid::stepped, &victim, &Cell::update, SAccess().write(&victim));
+
+    SSlotScheduler scheduler(2);
+    scheduler.emit(&grid, &Grid::stepped, 1);
+
+    S_CHECK(probe.order() == std::vector<int>({ 100 }));
+}
+
+S_TEST(schedulerCopiesByValueArgumentsForEachSlot)
+{
+    Probe probe;
+    Grid grid;
+    Cell first(&probe, 1), second(&probe, 2);
+    connect(&grid, &Grid::named, &first, &Cell::rename, SAccess().write(&first));
+    connect(&grid, &Grid::named, &second, &Cell::rename, SAccess().write(&second));
+
+    SSlotScheduler scheduler(2);
+    scheduler.emit(&grid, &Grid::named, std::string("cell"));
+
+    S_CHECK_EQUAL(first.m_name, std::string("cell"));
+    S_CHECK_EQUAL(second.m_name, std::string("cell"));
+}
+
+#endif // SOBJECT_THREAD_SAFE
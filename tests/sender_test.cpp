@@ -0,0 +1,147 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#include <memory>
+
+// onEmit e toSlot: un'operazione avviata termina una sola volta (valore, stop o errore)
+
+#if __cplusplus >= 201703L
+
+namespace
+{
+
+class Emitter : public SObject
+{
+public:
+    S_SIGNAL void valueChanged(int) {}
+
+    void fire(int value)
+    {
+        emitSignal(&Emitter::valueChanged, value);
+    }
+};
+
+// Completamenti ricevuti dall'operazione
+struct Completions
+{
+    int values  = 0;
+    int stopped = 0;
+    int errors  = 0;
+    int last    = 0;
+};
+
+class RecordingReceiver
+{
+public:
+    explicit RecordingReceiver(Completions* completions) : m_completions(completions) {};
+
+    void set_value(int value) && noexcept
+    {
+        ++m_completions->values;
+        m_completions->last = value;
+    }
+
+    template <typename Error>
+    void set_error(Error&&) && noexcept
+    {
+        ++m_completions->errors;
+    }
+
+    void set_stopped() && noexcept
+    {
+        ++m_completions->stopped;
+    }
+
+private:
+    Completions* m_completions;
+};
+
+class Receiver : public SObject
+{
+public:
+    S_SLOT void onValue(int value)
+    {
+        m_value = value;
+    }
+
+    int m_value = 0;
+};
+
+} // namespace
+
+
+
+// =======================================
+//
+//               onEmit
+//
+// =======================================
+
+S_TEST(emitOperationCompletesWithNextEmit)
+{
+    Emitter emitter;
+    Completions completions;
+    auto operation = onEmit(&emitter, &Emitter::valueChanged).connect(RecordingReceiver(&completions));
+    operation.start();
+
+    emitter.fire(4);
+    emitter.fire(5);
+    S_CHECK_EQUAL(completions.values, 1);
+    S_CHECK_EQUAL(completions.last, 4);
+    S_CHECK_EQUAL(completions.stopped + completions.errors, 0);
+    S_CHECK(not emitter.connectedWithObject(&operation));
+}
+
+S_TEST(emitOperationDestroyedBeforeEmit)
+{
+    Emitter emitter;
+    Completions completions;
+    {
+        auto operation = onEmit(&emitter, &Emitter::valueChanged).connect(RecordingReceiver(&completions));
+        operation.start();
+    }
+
+    // La connect è stata rimossa con lo stato: l'emit non raggiunge nulla
+    emitter.fire(4);
+    S_CHECK(emitter.getAllReceivers().empty());
+    S_CHECK_EQUAL(completions.values + completions.stopped + completions.errors, 0);
+}
+
+S_TEST(emitOperationStopsWhenEmitterIsDestroyed)
+{
+    std::unique_ptr<Emitter> emitter(new Emitter);
+    Completions completions;
+    auto operation = onEmit(emitter.get(), &Emitter::valueChanged).connect(RecordingReceiver(&completions));
+    operation.start();
+
+    emitter.reset();
+    S_CHECK_EQUAL(completions.stopped, 1);
+    S_CHECK_EQUAL(completions.values + completions.errors, 0);
+}
+
+S_TEST(emitOperationStopsWhenDisconnected)
+{
+    Emitter emitter;
+    Completions completions;
+    auto operation = onEmit(&emitter, &Emitter::valueChanged).connect(RecordingReceiver(&completions));
+    operation.start();
+
+    disconnect(&emitter, &Emitter::valueChanged);
+    emitter.fire(4);
+    S_CHECK_EQUAL(completions.stopped, 1);
+    S_CHECK_EQUAL(completions.values + completions.errors, 0);
+}
+
+S_TEST(emitOperationDeliversToSlot)
+{
+    Emitter emitter;
+    Receiver receiver;
+    auto operation = onEmit(&emitter, &Emitter::valueChanged).connect(toSlot(&receiver, &Receiver::onValue));
+    operation.start();
+
+    emitter.fire(9);
+    S_CHECK_EQUAL(receiver.m_value, 9);
+}
+
+#endif // __cplusplus >= 201703L
@@ -0,0 +1,81 @@
+#ifndef STEST_H
+#define STEST_H
+
+/* ===========================================================================
+ *
+ *    Mini framework dei test di SObject (nessuna dipendenza esterna).
+ *
+ *    Ogni S_TEST si registra all'avvio del programma, main li esegue tutti
+ *    o solo quelli il cui nome contiene l'argomento passato. S_CHECK e
+ *    S_CHECK_EQUAL segnalano il fallimento e proseguono il test.
+ *
+ * ===========================================================================
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace _stest
+{
+
+typedef void (*Function)();
+
+struct Test
+{
+    const char* name;
+    Function function;
+};
+
+inline std::vector<Test>& tests()
+{
+    static std::vector<Test> list;
+    return list;
+}
+
+// Controlli falliti dal test in esecuzione
+inline unsigned& failures()
+{
+    static unsigned count = 0;
+    return count;
+}
+
+struct Registrar
+{
+    Registrar(const char* name, Function function)
+    {
+        tests().push_back({ name, function });
+    }
+};
+
+inline void fail(const char* file, int line, const std::string& message)
+{
+    ++failures();
+    std::cerr << file << ":" << line << ": " << message << std::endl;
+}
+
+template <typename Actual, typename Expected>
+void checkEqual(const Actual& actual, const Expected& expected, const char* expression, const char* file, int line)
+{
+    if(actual == expected) return;
+
+    std::ostringstream message;
+    message << expression << ": " << actual << " != " << expected;
+    fail(file, line, message.str());
+}
+
+} // namespace _stest
+
+#define S_TEST(name)                                                        \
+    static void name();                                                     \
+    static const _stest::Registrar name##Registrar(#name, &name);           \
+    static void name()
+
+#define S_CHECK(condition)                                                  \
+    do { if(not (condition)) _stest::fail(__FILE__, __LINE__, #condition); } while(false)
+
+#define S_CHECK_EQUAL(actual, expected)                                     \
+    _stest::checkEqual((actual), (expected), #actual " == " #expected, __FILE__, __LINE__)
+
+#endif // STEST_H
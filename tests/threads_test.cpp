@@ -0,0 +1,370 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#ifdef SOBJECT_THREAD_SAFE
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Connect e disconnect concorrenti agli emit di altri thread (solo nelle modalità thread safe)
+
+namespace
+{
+
+class Emitter : public SObject
+{
+public:
+    S_SIGNAL void valueChanged(int) {}
+
+    void fire(int value)
+    {
+        emitSignal(&Emitter::valueChanged, value);
+    }
+};
+
+// Slot lenta di un plugin: segnala quando il suo codice è in esecuzione
+class PluginReceiver : public SObject
+{
+public:
+    S_SLOT void onValue(int)
+    {
+        m_running = true;
+        m_entered = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        m_running = false;
+    }
+
+    std::atomic<bool> m_running{ false };
+    std::atomic<bool> m_entered{ false };
+};
+
+class Counter : public SObject
+{
+public:
+    S_SLOT void onValue(int)
+    {
+        ++m_calls;
+    }
+
+    S_SLOT void onValueSlow(int)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        ++m_calls;
+    }
+
+    std::atomic<unsigned> m_calls{ 0 };
+};
+
+// Receiver di un loop: ricorda il thread dell'ultima chiamata
+class Worker : public SObject
+{
+public:
+    S_SLOT void onValue(int)
+    {
+        m_thread = std::this_thread::get_id();
+        ++m_calls;
+    }
+
+    std::atomic<std::thread::id> m_thread{ std::thread::id() };
+    std::atomic<unsigned> m_calls{ 0 };
+};
+
+// Slot accodata che ripartiziona il pool dal thread del suo loop
+class Balancer : public SObject
+{
+public:
+    explicit Balancer(SEventLoopPool* pool) : m_pool(pool) {};
+
+    S_SLOT void onValue(int)
+    {
+        m_report = m_pool->rebalance();
+        m_done = true;
+    }
+
+    SEventLoopPool* const m_pool;
+    SPlacementReport m_report;
+    std::atomic<bool> m_done{ false };
+};
+
+// Aspetto una condizione resa vera da un altro thread (al più 10 secondi)
+template <typename Predicate>
+bool waitFor(Predicate predicate)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while(not predicate())
+    {
+        if(std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+// Dentro l'emit connette e disconnette un receiver: la scrittura sospende i lock dell'emit
+class Rewirer : public SObject
+{
+public:
+    explicit Rewirer(Emitter* emitter) : m_emitter(emitter) {}
+
+    S_SLOT void onValue(int)
+    {
+        connect(m_emitter, &Emitter::valueChanged, &m_target, &Counter::onValue);
+        disconnect(m_emitter, &Emitter::valueChanged, &m_target, &Counter::onValue);
+        ++m_calls;
+    }
+
+    std::atomic<unsigned> m_calls{ 0 };
+
+private:
+    Emitter* m_emitter;
+    Counter m_target;
+};
+
+} // namespace
+
+
+
+// =======================================
+//
+//          Precedenza agli scrittori
+//
+// =======================================
+
+S_TEST(connectIsNotStarvedByEmits)
+{
+    // Emit continui e sovrapposti sullo stesso emitter non lasciano mai lo stripe senza lettori
+    Emitter emitter;
+    Counter counter;
+    connect(&emitter, &Emitter::valueChanged, &counter, &Counter::onValueSlow);
+
+    std::atomic<bool> stop{ false };
+    std::vector<std::thread> emitting;
+    for(int t = 0; t < 4; ++t) emitting.emplace_back([&]() { while(not stop) emitter.fire(1); });
+
+    Counter other;
+    for(int i = 0; i < 100; ++i)
+    {
+        S_CHECK(connect(&emitter, &Emitter::valueChanged, &other, &Counter::onValue));
+        disconnect(&emitter, &Emitter::valueChanged, &other, &Counter::onValue);
+    }
+
+    stop = true;
+    for(std::thread& thread : emitting) thread.join();
+    S_CHECK(not emitter.connectedWithObject(&other));
+}
+
+S_TEST(suspendedEmitsSurviveConcurrentWrites)
+{
+    // Le slot scrivono sull'emitter che le chiama mentre altri thread emettono e connettono receiver.
+    // I receiver vivono fino alla fine del test: con SOBJECT_SEQLOCK_EMIT un emit di un altro thread può
+    // chiamarne una slot anche dopo la disconnect, e ~SObject lo aspetta solo dopo il distruttore derivato
+    Emitter emitter;
+    Counter other;
+    Rewirer rewirer(&emitter);
+    connect(&emitter, &Emitter::valueChanged, &rewirer, &Rewirer::onValue);
+
+    const unsigned emits = 2000;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 2; ++t) threads.emplace_back([&]() { for(unsigned i = 0; i < emits; ++i) emitter.fire(1); });
+
+    threads.emplace_back([&]()
+    {
+        for(unsigned i = 0; i < emits; ++i)
+        {
+            connect(&emitter, &Emitter::valueChanged, &other, &Counter::onValue);
+            disconnect(&emitter, &Emitter::valueChanged, &other, &Counter::onValue);
+        }
+    });
+
+    for(std::thread& thread : threads) thread.join();
+    S_CHECK_EQUAL(rewirer.m_calls.load(), 2 * emits);
+    S_CHECK(emitter.getAllReceivers().size() == 1);
+}
+
+
+
+// =======================================
+//
+//          Disconnect del modulo
+//
+// =======================================
+
+S_TEST(disconnectModuleWaitsForRunningSlots)
+{
+    Emitter emitter;
+    PluginReceiver receiver;
+    SModuleToken module;
+    connect(&emitter, &Emitter::valueChanged, &receiver, &PluginReceiver::onValue, module);
+
+    // Una breve pausa tra gli emit: qui conta la disconnect, non la precedenza agli scrittori
+    std::atomic<bool> stop{ false };
+    std::thread emitting([&]()
+    {
+        while(not stop)
+        {
+            emitter.fire(1);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    // La disconnect parte mentre l'altro thread è dentro la slot
+    while(not receiver.m_entered) std::this_thread::yield();
+    disconnectModule(module);
+
+    // Al ritorno il codice del modulo non è più in esecuzione e non viene più chiamato
+    S_CHECK(not receiver.m_running);
+    S_CHECK(not emitter.connectedWithObject(&receiver));
+
+    stop = true;
+    emitting.join();
+    S_CHECK(not receiver.m_running);
+}
+
+
+
+// =======================================
+//
+//             Event loop
+//
+// =======================================
+
+S_TEST(assignDuringQueuedEmits)
+{
+    // Lo stato del receiver viene creato dal pool mentre un altro thread accoda chiamate verso di lui
+    Emitter emitter;
+    Counter counter;
+    connect(&emitter, &Emitter::valueChanged, &counter, &Counter::onValue, SQueuedConnection);
+
+    const unsigned emits = 20000;
+    {
+        SEventLoopPool pool(2, false);
+        std::thread emitting([&]() { for(unsigned i = 0; i < emits; ++i) emitter.fire(1); });
+
+        while(counter.m_calls == 0) std::this_thread::yield();
+        pool.assign(&counter);
+
+        emitting.join();
+        pool.release(&counter);
+    }
+
+    // Chiamate dirette o accodate (eseguite dal pool prima della chiusura): nessuna va persa
+    S_CHECK_EQUAL(counter.m_calls.load(), emits);
+}
+
+S_TEST(migrateMovesQueuedSlotsToTheNewShard)
+{
+    Emitter emitter;
+    Worker worker;
+    connect(&emitter, &Emitter::valueChanged, &worker, &Worker::onValue, SQueuedConnection);
+
+    SEventLoopPool pool(2, false);
+    pool.assign(&worker, 0);
+
+    emitter.fire(1);
+    S_CHECK(waitFor([&] { return worker.m_calls == 1; }));
+    const std::thread::id before = worker.m_thread;
+
+    // Il cambio avviene nel loop dello shard 0, le chiamate successive girano nello shard 1
+    pool.migrate(&worker, 1);
+    S_CHECK(waitFor([&] { return pool.shardOf(&worker) == 1; }));
+
+    emitter.fire(2);
+    S_CHECK(waitFor([&] { return worker.m_calls == 2; }));
+    S_CHECK(worker.m_thread.load() != before);
+
+    pool.release(&worker);
+}
+
+S_TEST(rebalanceColocatesTalkingObjects)
+{
+    Emitter emitter;
+    Worker worker;
+    connect(&emitter, &Emitter::valueChanged, &worker, &Worker::onValue, SQueuedConnection);
+
+    SEventLoopPool pool(2, false);
+    pool.assign(&emitter, 0);
+    pool.assign(&worker, 1);
+
+    for(int i = 0; i < 100; ++i) emitter.fire(i);
+    S_CHECK(waitFor([&] { return worker.m_calls == 100; }));
+
+    // Con due oggetti e imbalance 1 uno shard può contenerli entrambi
+    const SPlacementReport report = pool.rebalance(1.0);
+    S_CHECK_EQUAL(report.traffic, std::uint64_t(100));
+    S_CHECK_EQUAL(report.crossTrafficBefore, std::uint64_t(100));
+    S_CHECK_EQUAL(report.crossTrafficAfter, std::uint64_t(0));
+    S_CHECK_EQUAL(report.moves.size(), std::size_t(1));
+    S_CHECK_EQUAL(pool.placementReport().moves.size(), std::size_t(1));
+
+    S_CHECK(waitFor([&] { return pool.shardOf(&emitter) == pool.shardOf(&worker); }));
+
+    pool.release(&emitter);
+    pool.release(&worker);
+}
+
+S_TEST(rebalanceFromLoopThreadReturnsEmptyReport)
+{
+    Emitter emitter;
+    SEventLoopPool pool(2, false);
+    Balancer balancer(&pool);
+    connect(&emitter, &Emitter::valueChanged, &balancer, &Balancer::onValue, SQueuedConnection);
+    pool.assign(&balancer, 0);
+
+    // Senza il controllo il campionamento aspetterebbe per sempre il loop che lo ha chiamato
+    emitter.fire(1);
+    S_CHECK(waitFor([&] { return balancer.m_done.load(); }));
+    S_CHECK(balancer.m_report.moves.empty());
+    S_CHECK(balancer.m_report.objects.empty());
+
+    pool.release(&balancer);
+}
+
+S_TEST(stopRunsQueuedTasksAndReleasesObjects)
+{
+    Emitter emitter;
+    Worker worker;
+    connect(&emitter, &Emitter::valueChanged, &worker, &Worker::onValue, SQueuedConnection);
+
+    SEventLoopPool pool(2, false);
+    pool.assign(&worker, 0);
+    for(int i = 0; i < 100; ++i) emitter.fire(i);
+
+    // Anche una migrazione ancora in coda viene eseguita o scartata prima del rilascio
+    pool.migrate(&worker, 1);
+    pool.stop();
+    S_CHECK_EQUAL(worker.m_calls.load(), 100u);
+    S_CHECK_EQUAL(pool.shardOf(&worker), pool.size());
+
+    // Dopo stop() l'oggetto non ha più un loop: la slot viene chiamata subito
+    emitter.fire(1);
+    S_CHECK_EQUAL(worker.m_calls.load(), 101u);
+    S_CHECK(worker.m_thread.load() == std::this_thread::get_id());
+
+    pool.assign(&worker, 0);
+    S_CHECK_EQUAL(pool.shardOf(&worker), pool.size());
+    S_CHECK(pool.rebalance().moves.empty());
+}
+
+S_TEST(poolDestroyedBeforeAssignedObjects)
+{
+    Emitter emitter;
+    Worker* worker = new Worker;
+    connect(&emitter, &Emitter::valueChanged, worker, &Worker::onValue, SQueuedConnection);
+
+    {
+        SEventLoopPool pool(2, false);
+        pool.assign(worker, 1);
+        emitter.fire(1);
+    }
+
+    // Il distruttore del pool ha eseguito la chiamata accodata e rilasciato l'oggetto
+    S_CHECK_EQUAL(worker->m_calls.load(), 1u);
+    emitter.fire(2);
+    S_CHECK_EQUAL(worker->m_calls.load(), 2u);
+
+    delete worker;
+}
+
+#endif // SOBJECT_THREAD_SAFE
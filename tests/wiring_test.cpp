@@ -0,0 +1,139 @@
+#include "stest.h"
+
+#include "sobject.h"
+
+#include <vector>
+
+// rewire: differenza minima tra le connect desiderate e quelle attive, con il replay delle nuove connect
+
+namespace
+{
+
+class Router : public SObject
+{
+public:
+    S_SIGNAL void packet(int) {}
+
+    void send(int value)
+    {
+        emitSignal(&Router::packet, value);
+    }
+
+    void enableReplay()
+    {
+        setSignalReplay(&Router::packet, 1);
+    }
+};
+
+class Backend : public SObject
+{
+public:
+    S_SLOT void handle(int value)
+    {
+        m_values.push_back(value);
+    }
+
+    std::vector<int> m_values;
+};
+
+// Al replay disconnette un altro backend, aggiunto dallo stesso rewire
+class Evictor : public SObject
+{
+public:
+    Evictor(Router* router, Backend* victim) : m_router(router), m_victim(victim) {}
+
+    S_SLOT void handle(int value)
+    {
+        m_values.push_back(value);
+        disconnect(m_router, &Router::packet, m_victim);
+    }
+
+    std::vector<int> m_values;
+
+private:
+    Router* m_router;
+    Backend* m_victim;
+};
+
+} // namespace
+
+
+
+S_TEST(rewireAppliesOnlyTheDifference)
+{
+    Router router;
+    Backend a, b, c;
+    connect(&router, &Router::packet, &a, &Backend::handle);
+    connect(&router, &Router::packet, &b, &Backend::handle);
+
+    SWiring wiring;
+    wiring.connect(&router, &Router::packet, &a, &Backend::handle);
+    wiring.connect(&router, &Router::packet, &c, &Backend::handle);
+
+    const SRewireResult result = rewire(wiring);
+    S_CHECK_EQUAL(result.added, std::size_t(1));
+    S_CHECK_EQUAL(result.removed, std::size_t(1));
+
+    router.send(1);
+    S_CHECK(a.m_values == std::vector<int>({ 1 }));
+    S_CHECK(b.m_values.empty());
+    S_CHECK(c.m_values == std::vector<int>({ 1 }));
+}
+
+S_TEST(rewireReplaysToNewConnections)
+{
+    Router router;
+    router.enableReplay();
+    router.send(4);
+
+    Backend replayed, plain;
+    SWiring wiring;
+    wiring.connect(&router, &Router::packet, &replayed, &Backend::handle, SReplayLastConnection);
+    wiring.connect(&router, &Router::packet, &plain, &Backend::handle);
+    rewire(wiring);
+
+    S_CHECK(replayed.m_values == std::vector<int>({ 4 }));
+    S_CHECK(plain.m_values.empty());
+
+    // Connect già presenti: nessun nuovo replay
+    rewire(wiring);
+    S_CHECK(replayed.m_values == std::vector<int>({ 4 }));
+}
+
+S_TEST(rewireReplayedSlotRemovesAnotherNewSlot)
+{
+    Router router;
+    router.enableReplay();
+    router.send(4);
+
+    Backend victim;
+    Evictor evictor(&router, &victim);
+    SWiring wiring;
+    wiring.connect(&router, &Router::packet, &evictor, &Evictor::handle, SReplayLastConnection);
+    wiring.connect(&router, &Router::packet, &victim, &Backend::handle, SReplayLastConnection);
+    rewire(wiring);
+
+    // La slot rimossa durante il replay non lo riceve e non viene più chiamata
+    S_CHECK(evictor.m_values == std::vector<int>({ 4 }));
+    S_CHECK(victim.m_values.empty());
+    S_CHECK(not router.connectedWithObject(&victim));
+
+    router.send(5);
+    S_CHECK(victim.m_values.empty());
+}
+
+S_TEST(rewireSingleShotReplayIsRemoved)
+{
+    Router router;
+    router.enableReplay();
+    router.send(4);
+
+    Backend backend;
+    SWiring wiring;
+    wiring.connect(&router, &Router::packet, &backend, &Backend::handle, SReplayLastConnection | SSingleShotConnection);
+    rewire(wiring);
+
+    router.send(5);
+    S_CHECK(backend.m_values == std::vector<int>({ 4 }));
+    S_CHECK(not router.connectedWithObject(&backend));
+}